@@ -0,0 +1,286 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+生成C++黄金回归测试使用的二进制数据 (golden_fixtures.bin)
+
+每个样本记录Python参考实现 (source/emotions_dlib.py) 各阶段的输出:
+原始关键点、Procrustes标准化行、正面化关键点、几何特征、模型预测和情绪标签。
+C++端通过 `FacialExpressionAnalysis --golden` 在进程内逐阶段比对，不再需要Python运行时。
+
+--kernels 生成只覆盖数值内核的数据 (kernel_fixtures.bin): 合成人脸关键点和随机正面化权重，
+只需要numpy，不依赖模型文件和dlib，由 FacialExpressionAnalysisKernelParityTest 在每次构建后比对。
+
+文件格式 (小端):
+    char[8]  magic = b"EMOGOLD1"
+    uint32   version = 1
+    uint32   num_cases
+    uint32   num_landmarks (68)
+    uint32   feature_dim
+    uint32   full_features
+    float32  raw_landmarks[num_cases][136]   交错的 x, y
+    float32  standardized[num_cases][137]    [x1..x68, y1..y68, 1]
+    float32  frontal[num_cases][136]         [x1..x68, y1..y68]
+    float32  features[num_cases][feature_dim]
+    float32  prediction[num_cases][2]        模型原始输出 (arousal, valence)
+    float32  avi[num_cases][3]               取整并截断后的 (arousal, valence, intensity)
+    int32    label_id[num_cases]             0-23，-1 Neutral，-2 Unknown
+    int32    intensity_level[num_cases]      0-3，Neutral/Unknown 为 -1
+
+内核数据格式 (小端):
+    char[8]  magic = b"EMOKERN1"
+    uint32   version = 1
+    uint32   num_cases
+    uint32   num_landmarks (68)
+    float32  weights[137][136]                 合成的正面化权重
+    float32  raw_landmarks[num_cases][136]
+    float32  standardized[num_cases][137]
+    float32  frontal[num_cases][136]
+    float32  features_reduced[num_cases][1275]
+    float32  features_full[num_cases][2278]
+
+用法:
+    python generate_golden_fixtures.py [--images ../data/images] [--output ../data/golden/golden_fixtures.bin]
+    python generate_golden_fixtures.py --kernels [--output ../data/golden/kernel_fixtures.bin]
+"""
+
+import sys
+import os
+import struct
+import argparse
+import math
+from pathlib import Path
+
+import numpy as np
+
+# 添加源码路径
+sys.path.append(str(Path(__file__).resolve().parent.parent / 'source'))
+
+try:
+    from emotions_dlib import EmotionsDlib, GeometricFeaturesDlib, LandmarkFrontalizationDlib
+except ImportError as e:
+    print(f"导入错误: {e}")
+    print("请确保安装了所有必要的依赖项")
+    sys.exit(1)
+
+MAGIC = b"EMOGOLD1"
+KERNEL_MAGIC = b"EMOKERN1"
+VERSION = 1
+NUM_LANDMARKS = 68
+
+INTENSITY_NAMES = ["Slightly", "Moderately", "Very", "Extremely"]
+SECTOR_NAMES = [
+    "pleased", "happy", "delighted", "excited", "astonished", "aroused",
+    "tensed", "alarmed", "afraid", "annoyed", "distressed", "frustrated", "miserable",
+    "sad", "gloomy", "depressed", "bored", "droopy", "tired", "sleepy",
+    "calm", "serene", "content", "satisfied",
+]
+
+
+def label_to_code(text):
+    """将 avi_to_text 的输出转换为 (label_id, intensity_level)"""
+    parts = text.strip().split()
+    if parts == ["Neutral"]:
+        return -1, -1
+    if len(parts) != 2 or parts[0] not in INTENSITY_NAMES or parts[1] not in SECTOR_NAMES:
+        return -2, -1
+    return SECTOR_NAMES.index(parts[1]), INTENSITY_NAMES.index(parts[0])
+
+
+def detect_landmarks(image_dir, predictor):
+    """用dlib检测数据集中全部图像的人脸关键点"""
+    import dlib
+    detector = dlib.get_frontal_face_detector()
+    shapes = []
+
+    for path in sorted(Path(image_dir).iterdir()):
+        if path.suffix.lower() not in ('.jpg', '.jpeg', '.png', '.bmp'):
+            continue
+        try:
+            image = dlib.load_rgb_image(str(path))
+        except RuntimeError:
+            print(f"跳过无法读取的图像: {path.name}")
+            continue
+
+        faces = detector(image, 1)
+        for face in faces:
+            shape = predictor(image, face)
+            landmarks = np.array([[shape.part(i).x, shape.part(i).y]
+                                  for i in range(NUM_LANDMARKS)], dtype=np.float64)
+            shapes.append(landmarks)
+        print(f"{path.name}: {len(faces)} 张人脸")
+
+    return shapes
+
+
+def augment(shapes, per_shape, rng):
+    """对真实关键点施加随机相似变换和抖动，覆盖不同的旋转、尺度和位置"""
+    augmented = []
+    for landmarks in shapes:
+        center = landmarks.mean(axis=0)
+        for _ in range(per_shape):
+            angle = math.radians(rng.uniform(-20.0, 20.0))
+            scale = rng.uniform(0.5, 2.0)
+            rotation = np.array([[math.cos(angle), -math.sin(angle)],
+                                 [math.sin(angle), math.cos(angle)]])
+            shift = rng.uniform(-100.0, 100.0, size=2)
+            moved = (landmarks - center) @ rotation.T * scale + center + shift
+            moved += rng.normal(0.0, 1.0, size=moved.shape)
+            augmented.append(moved)
+    return augmented
+
+
+def run_reference(estimator, landmarks):
+    """按 EmotionsDlib.get_emotions 的流程计算各阶段输出"""
+    frontalizer = estimator.frontalizer
+
+    standard = frontalizer.get_procrustes(landmarks, template_landmarks=None)
+    row = np.hstack((standard[:, 0].T, standard[:, 1].T, 1))
+    frontal_vector = np.matmul(row, frontalizer.frontalization_weights)
+    frontal = frontalizer.get_landmark_matrix(frontal_vector)
+
+    features = estimator.geom_feat.get_features(frontal)
+    prediction = estimator.emotion_model.predict(features.reshape(1, -1))[0]
+
+    emotions = estimator.get_emotions(landmarks)['emotions']
+    label_id, intensity_level = label_to_code(emotions['name'])
+
+    return {
+        'standardized': row,
+        'frontal': frontal_vector,
+        'features': features,
+        'prediction': prediction[:2],
+        'avi': [emotions['arousal'], emotions['valence'], emotions['intensity']],
+        'label_id': label_id,
+        'intensity_level': intensity_level,
+    }
+
+
+def synthetic_face(rng):
+    """按dlib 68点的部位顺序构造一张人脸（下颌、眉毛、鼻子、眼睛、嘴），每个点加随机抖动"""
+    points = []
+    for t in np.linspace(0.0, math.pi, 17):                    # 0-16 下颌，从左耳经下巴到右耳
+        points.append((-math.cos(t), 1.1 * math.sin(t)))
+    for side in (-1.0, 1.0):                                     # 17-26 眉毛
+        for x in np.linspace(0.8, 0.2, 5)[::int(-side)]:
+            points.append((side * x, -0.45 - 0.08 * math.sin(math.pi * (x - 0.2) / 0.6)))
+    for y in np.linspace(-0.3, 0.2, 4):                         # 27-30 鼻梁
+        points.append((0.0, y))
+    for x in np.linspace(-0.2, 0.2, 5):                         # 31-35 鼻翼
+        points.append((x, 0.3 - 0.04 * math.cos(math.pi * x / 0.4)))
+    for cx in (-0.4, 0.4):                                       # 36-47 眼睛
+        for t in np.linspace(0.0, 2.0 * math.pi, 7)[:-1]:
+            points.append((cx - 0.15 * math.cos(t), -0.2 - 0.06 * math.sin(t)))
+    for rx, ry, count in ((0.35, 0.15, 12), (0.2, 0.05, 8)):    # 48-59 外唇, 60-67 内唇
+        for t in np.linspace(0.0, 2.0 * math.pi, count + 1)[:-1]:
+            points.append((-rx * math.cos(t), 0.6 - ry * math.sin(t)))
+
+    face = np.array(points, dtype=np.float64) * 100.0 + np.array([320.0, 240.0])
+    return face + rng.normal(0.0, 3.0, size=face.shape)
+
+
+def write_kernel_fixtures(output, num_faces, per_face, seed):
+    """用参考实现的Procrustes、正面化和几何特征生成内核级数据，不需要模型文件"""
+    rng = np.random.default_rng(seed)
+
+    # Identity plus noise keeps the frontal shape face-like while exercising every weight
+    size = 2 * NUM_LANDMARKS
+    weights = np.vstack((np.eye(size) + rng.normal(0.0, 0.05, size=(size, size)),
+                         rng.normal(0.0, 0.1, size=(1, size))))
+
+    frontalizer = LandmarkFrontalizationDlib.__new__(LandmarkFrontalizationDlib)
+    frontalizer.TOTAL_LANDMARKS = NUM_LANDMARKS
+    frontalizer.frontalization_weights = weights.astype(np.float32).astype(np.float64)
+    geometry = {full: GeometricFeaturesDlib(full_size=full) for full in (False, True)}
+
+    shapes = [synthetic_face(rng) for _ in range(num_faces)]
+    cases = shapes + augment(shapes, per_face, rng)
+
+    columns = {key: [] for key in ('raw', 'standardized', 'frontal', 'reduced', 'full')}
+    for landmarks in cases:
+        landmarks = landmarks.astype(np.float32).astype(np.float64)
+        standard = frontalizer.get_procrustes(landmarks, template_landmarks=None)
+        row = np.hstack((standard[:, 0].T, standard[:, 1].T, 1))
+        frontal_vector = np.matmul(row, frontalizer.frontalization_weights)
+        frontal = frontalizer.get_landmark_matrix(frontal_vector)
+
+        columns['raw'].append(landmarks.reshape(-1))
+        columns['standardized'].append(row)
+        columns['frontal'].append(frontal_vector)
+        columns['reduced'].append(geometry[False].get_features(frontal))
+        columns['full'].append(geometry[True].get_features(frontal))
+
+    output = Path(output)
+    output.parent.mkdir(parents=True, exist_ok=True)
+    with open(output, 'wb') as f:
+        f.write(KERNEL_MAGIC)
+        f.write(struct.pack('<3I', VERSION, len(cases), NUM_LANDMARKS))
+        f.write(np.asarray(weights, dtype='<f4').tobytes())
+        for key in ('raw', 'standardized', 'frontal', 'reduced', 'full'):
+            f.write(np.asarray(columns[key], dtype='<f4').tobytes())
+
+    print(f"✅ 已写入 {len(cases)} 个内核样本到 {output}")
+
+
+def main():
+    base = Path(__file__).resolve().parent
+    parser = argparse.ArgumentParser(description="生成C++黄金回归测试数据")
+    parser.add_argument('--models', default=str(base.parent / 'models'))
+    parser.add_argument('--images', default=str(base.parent / 'data' / 'images'))
+    parser.add_argument('--output', default=None)
+    parser.add_argument('--augment', type=int, default=8, help="每张真实人脸生成的变换样本数")
+    parser.add_argument('--seed', type=int, default=42)
+    parser.add_argument('--kernels', action='store_true', help="只生成数值内核数据（合成关键点，不需要模型）")
+    args = parser.parse_args()
+
+    golden = base.parent / 'data' / 'golden'
+    if args.kernels:
+        write_kernel_fixtures(args.output or golden / 'kernel_fixtures.bin', 4, 5, args.seed)
+        return
+    args.output = args.output or str(golden / 'golden_fixtures.bin')
+
+    import dlib
+    models = Path(args.models)
+    estimator = EmotionsDlib(
+        file_emotion_model=str(models / "model_emotion_pls=30_fullfeatures=False_py312.joblib"),
+        file_frontalization_model=str(models / "model_frontalization.npy"),
+    )
+    predictor = dlib.shape_predictor(str(models / "shape_predictor_68_face_landmarks.dat"))
+
+    shapes = detect_landmarks(args.images, predictor)
+    if not shapes:
+        print("❌ 没有检测到任何人脸")
+        sys.exit(1)
+
+    rng = np.random.default_rng(args.seed)
+    cases = shapes + augment(shapes, args.augment, rng)
+
+    columns = {key: [] for key in ('raw', 'standardized', 'frontal', 'features',
+                                   'prediction', 'avi', 'label_id', 'intensity_level')}
+    for landmarks in cases:
+        # C++只看到float32的输入，参考实现也从同样的取值出发
+        landmarks = landmarks.astype(np.float32).astype(np.float64)
+        reference = run_reference(estimator, landmarks)
+
+        columns['raw'].append(landmarks.reshape(-1))
+        for key in ('standardized', 'frontal', 'features', 'prediction', 'avi',
+                    'label_id', 'intensity_level'):
+            columns[key].append(reference[key])
+
+    feature_dim = len(columns['features'][0])
+    output = Path(args.output)
+    output.parent.mkdir(parents=True, exist_ok=True)
+
+    with open(output, 'wb') as f:
+        f.write(MAGIC)
+        f.write(struct.pack('<5I', VERSION, len(cases), NUM_LANDMARKS, feature_dim,
+                            int(bool(estimator.full_features))))
+        for key in ('raw', 'standardized', 'frontal', 'features', 'prediction', 'avi'):
+            f.write(np.asarray(columns[key], dtype='<f4').tobytes())
+        for key in ('label_id', 'intensity_level'):
+            f.write(np.asarray(columns[key], dtype='<i4').tobytes())
+
+    print(f"✅ 已写入 {len(cases)} 个样本 ({len(shapes)} 张真实人脸) 到 {output}")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,199 @@
+#pragma once
+
+#include <opencv2/opencv.hpp>
+#include "emotion_analyzer.h"
+#include <vector>
+#include <string>
+
+// 端到端基准测试配置
+struct BenchmarkConfig {
+    std::string image_dir = "../data/images";
+    std::vector<int> resolutions = {320, 640, 1280};  // 缩放后的长边像素
+    int composite_faces = 4;       // 合成多人脸图像中的人脸数（网格排列）
+    int composite_tile = 400;      // 合成图像中每个格子的边长
+    int warmup_iterations = 2;     // 不计时的预热轮数
+    int iterations = 5;            // 计时轮数（每轮遍历整个语料）
+    double regression_threshold = 0.10;  // 相对基线允许的退化比例
+};
+
+// 基准测试结果（同时也是基线文件的内容）
+struct BenchmarkResult {
+    int corpus_size = 0;
+    int measured_images = 0;
+    double total_seconds = 0.0;
+    double images_per_second = 0.0;
+    double mean_ms = 0.0;
+    double p50_ms = 0.0;
+    double p99_ms = 0.0;
+    double peak_rss_mb = 0.0;
+    std::string timestamp;
+};
+
+// 检测器配置扫描的一行: 速度与相对参考配置的召回率
+struct DetectorSweepEntry {
+    std::string name;
+    DetectorConfig config;
+    std::string detector;      // 实际运行的检测器后端
+    double ms_per_image = 0.0;
+    int faces_found = 0;
+    int faces_matched = 0;     // 与参考检测结果交并比 >= 0.5 的人脸数
+    double recall = 0.0;
+};
+
+// 关键点回归器对比: dlib shape_predictor vs 内置ERT求值器
+struct LandmarkComparison {
+    int faces = 0;
+    double dlib_ms_per_face = 0.0;
+    double native_ms_per_face = 0.0;
+    double mean_error_px = 0.0;      // 对应关键点的平均欧氏距离
+    double max_error_px = 0.0;
+    double identical_ratio = 0.0;    // 坐标完全相同的关键点比例
+};
+
+// 截断级联的一行: 相对完整模型的关键点RMSE与arousal/valence偏差
+struct LandmarkBudgetEntry {
+    std::string name;
+    ErtBudget budget;
+    double ms_per_face = 0.0;      // 关键点回归加批量推理
+    int faces = 0;                 // 参与比较的人脸数
+    double rmse_px = 0.0;          // 关键点均方根误差（像素）
+    double rmse_iod = 0.0;         // 按外眼角间距归一化的均方根误差
+    double arousal_mae = 0.0;
+    double valence_mae = 0.0;
+    double max_av_deviation = 0.0; // arousal/valence的最大绝对偏差
+};
+
+// 视频关键点跟踪报告: 模拟平移的相机画面上，完整回归与热启动的关键点耗时和偏差
+struct TrackingReport {
+    ErtBudget budget;                  // 两种模式共用的关键点预算
+    int frames = 0;                    // 两种模式都检测到人脸的帧数
+    double full_landmark_ms = 0.0;     // 每帧关键点回归耗时（完整回归）
+    double tracked_landmark_ms = 0.0;  // 每帧关键点回归耗时（热启动）
+    double mean_first_cascade = 0.0;   // 热启动平均从第几级级联开始
+    int full_runs = 0;                 // 跟踪模式下完整回归的帧数
+    double rmse_px = 0.0;              // 热启动相对完整回归的关键点均方根误差
+    double max_av_deviation = 0.0;     // arousal/valence的最大绝对偏差
+};
+
+// 共享模型报告: 依次创建多个分析器，第一个从磁盘加载模型，其余从ModelRegistry复用
+struct SharedModelReport {
+    int analyzers = 0;
+    double first_init_ms = 0.0;       // 第一个分析器创建并初始化的耗时
+    double next_init_ms = 0.0;        // 其余分析器的平均耗时
+    double rss_before_mb = 0.0;       // 峰值RSS: 创建前
+    double rss_after_first_mb = 0.0;  // 第一个分析器初始化后
+    double rss_after_all_mb = 0.0;    // 全部分析器初始化后
+    ModelRegistryStats registry;
+};
+
+// 热重载报告: 分析线程持续处理语料时另一线程反复重载ONNX模型，比较重载前后的延迟分布
+struct HotReloadReport {
+    int requests = 0;                 // 重载期间完成的分析请求数
+    double steady_p50_ms = 0.0;       // 无重载时
+    double steady_p99_ms = 0.0;
+    double steady_max_ms = 0.0;
+    double reload_p50_ms = 0.0;       // 重载期间
+    double reload_p99_ms = 0.0;
+    double reload_max_ms = 0.0;
+    int reloads = 0;                  // 成功的重载次数
+    int failed_reloads = 0;
+    double mean_reload_ms = 0.0;      // 单次重载（加载+预热+发布）的平均耗时
+    int failed_requests = 0;          // 无重载时成功、重载期间失败的请求
+    int mismatches = 0;               // 结果与无重载时不同的请求（模型内容相同，应为0）
+    uint64_t generation = 0;          // 结束时的模型代数
+};
+
+// ONNX优化模型缓存报告: 各种启动方式的会话创建耗时，以及缓存模型与未优化模型的输出差异
+struct OnnxCacheReport {
+    bool available = false;
+    int runs = 0;
+    double unoptimized_ms = 0.0;    // 关闭图优化
+    double optimized_ms = 0.0;      // 每次启动都重新优化（不缓存）
+    double first_ms = 0.0;          // 首次启动: 优化并写出缓存
+    double cached_ms = 0.0;         // 之后的启动: 加载缓存，关闭图优化
+    bool cache_hit = false;         // 之后的启动是否都命中缓存
+    std::string cache_file;
+    double max_output_diff = 0.0;   // 缓存模型与未优化模型输出的最大绝对差
+};
+
+class Benchmark {
+public:
+    Benchmark(EmotionAnalyzer& analyzer, const BenchmarkConfig& config);
+
+    // 构建语料: 各分辨率的数据集图像 + 合成多人脸图像，返回是否至少有一张图像
+    bool buildCorpus();
+
+    // 对语料运行完整流程（单人脸图像为工作区版本的analyzeEmotion，合成图像为检测全部人脸+批量推理）
+    // 并统计吞吐、延迟和峰值内存
+    BenchmarkResult run();
+
+    // 在原始分辨率的源图像上比较一组检测器配置；第一项作为召回率参考（应为最完备的配置）
+    std::vector<DetectorSweepEntry> runDetectorSweep(const std::vector<DetectorSweepEntry>& configs);
+    
+    // 默认扫描: 上采样参考、dlib默认、最小人脸、金字塔比例和阈值的若干组合
+    static std::vector<DetectorSweepEntry> defaultDetectorSweep();
+    
+    static void printDetectorSweep(const std::vector<DetectorSweepEntry>& entries);
+    
+    // 在源图像检测到的人脸上分别运行dlib和内置求值器（各自从shape_predictor_path加载），比较速度和结果
+    LandmarkComparison compareShapePredictors(const std::string& shape_predictor_path);
+    
+    static void printLandmarkComparison(const LandmarkComparison& comparison);
+    
+    // 在源图像检测到的人脸上比较一组关键点预算，以完整级联的结果为参考
+    std::vector<LandmarkBudgetEntry> runLandmarkBudgetReport(const std::vector<LandmarkBudgetEntry>& budgets);
+    
+    // 默认: 完整级联、前2/4/6/8级、每级250棵树及其组合
+    static std::vector<LandmarkBudgetEntry> defaultLandmarkBudgets();
+    
+    static void printLandmarkBudgetReport(const std::vector<LandmarkBudgetEntry>& entries);
+    
+    // 每张源图像模拟frames_per_source帧缓慢平移的画面，分别关闭/开启关键点跟踪运行工作区分析
+    TrackingReport runTrackingReport(int frames_per_source = 60);
+    
+    static void printTrackingReport(const TrackingReport& report);
+    
+    // 用相同的模型文件依次创建并初始化count个分析器（须在进程内首次加载模型前运行）
+    static SharedModelReport runSharedModelReport(const std::string& onnx_model_path,
+                                                  const std::string& frontalization_model_path,
+                                                  const std::string& shape_predictor_path,
+                                                  const DetectorConfig& detector_config, int count);
+    
+    static void printSharedModelReport(const SharedModelReport& report);
+    
+    // 将ONNX模型复制为两个临时文件，工作区分析语料的同时每隔reload_interval_ms交替重载，结束后恢复原模型
+    HotReloadReport runHotReloadReport(const std::string& onnx_model_path, int reload_interval_ms = 50);
+    
+    static void printHotReloadReport(const HotReloadReport& report);
+    
+    // 删除该模型的缓存后，按config依次测量首次启动、缓存启动、不缓存和不优化的会话创建耗时（后三者各runs次取平均）
+    static OnnxCacheReport runOnnxCacheReport(const std::string& onnx_model_path, const OnnxSessionConfig& config,
+                                              int runs);
+    
+    static void printOnnxCacheReport(const OnnxCacheReport& report);
+    
+    // 基线文件读写（JSON）
+    static bool saveBaseline(const BenchmarkResult& result, const std::string& path);
+    static bool loadBaseline(const std::string& path, BenchmarkResult& result);
+
+    // 与基线比较，任一指标退化超过阈值时返回false；report为逐项对比
+    static bool compareWithBaseline(const BenchmarkResult& current, const BenchmarkResult& baseline,
+                                    double threshold, std::string& report);
+
+    // 进程峰值常驻内存（MB）
+    static double peakResidentMemoryMB();
+
+    static void printResult(const BenchmarkResult& result);
+
+private:
+    EmotionAnalyzer& analyzer_;
+    BenchmarkConfig config_;
+    std::vector<cv::Mat> sources_;   // 原始分辨率的源图像
+    std::vector<cv::Mat> corpus_;
+    size_t composite_begin_ = 0;     // corpus_中从此下标起为合成多人脸图像
+
+    cv::Mat makeComposite(const std::vector<cv::Mat>& faces);
+    
+    // 按服务的方式分析一张语料图像: 单人脸图像走工作区版本（不打印），合成图像检测全部人脸后批量推理
+    void analyzeCorpusImage(size_t index, AnalysisWorkspace& workspace, EmotionResult& result);
+};
@@ -16,84 +16,320 @@
 #include <cnpy.h>
 #endif
 
+#include "emotion_labels.h"
+#include "face_detection.h"
+#include "ert_shape_predictor.h"
+#include "model_registry.h"
+#include "onnx_session_cache.h"
+
+#include <cstdint>
 #include <vector>
 #include <string>
 #include <memory>
+#include <mutex>
+#include <atomic>
+#include <functional>
 
 struct EmotionResult {
     float arousal;
     float valence;
     float intensity;
     std::string emotion_name;
+    EmotionLabels::EmotionCode code{EmotionLabels::kLabelNeutral, -1};  // 紧凑编码，标签见EmotionLabels::label
 };
 
 struct LandmarksData {
     std::vector<cv::Point2f> raw_landmarks;
     std::vector<cv::Point2f> frontal_landmarks;
+    int detection_rung = -1;   // 命中的检测阶梯级（未启用阶梯时为0），未检测到人脸为-1
+};
+
+// 单个人脸的分析结果
+struct FaceEmotion {
+    cv::Rect rect;                        // 人脸框（图像坐标）
+    std::vector<cv::Point2f> landmarks;   // 68个原始关键点
+    EmotionResult emotion;
+    bool success = false;                 // 框无效或特征提取失败时为false，emotion为Neutral
+};
+
+// 预热结果
+struct WarmupReport {
+    bool success = false;
+    int iterations_run = 0;
+    int steady_state_iteration = -1;   // 达到稳态的轮次（从1开始），未达到时为-1
+    double first_ms = 0.0;             // 第一轮耗时
+    double steady_ms = 0.0;            // 最后一轮耗时
+};
+
+// 视频关键点跟踪: 工作区版本的分析从上一帧关键点（按人脸框的位移和缩放对齐到本帧）热启动，
+// 人脸运动越小跳过的粗调级联越多。运动量 = 框中心位移 / 上一帧框宽 + |ln(框宽之比)|；级联数按关键点预算截断后计
+struct LandmarkTracking {
+    bool enabled = false;
+    double small_motion = 0.03;    // 低于此值只运行最后1/3的级联
+    double large_motion = 0.15;    // 低于此值运行后2/3的级联，否则从平均形状完整回归
+    int max_tracked_frames = 30;   // 连续热启动帧数上限，达到后完整回归一次以免误差累积
+};
+
+// 单帧分析的可复用工作区: 由prepareWorkspace预分配全部中间缓冲区并绑定ONNX输入输出张量，
+// 之后每帧复用，稳态下关键点之后的各阶段不再分配堆内存。每个线程使用各自的工作区
+struct AnalysisWorkspace {
+    std::vector<cv::Point2f> raw_landmarks;
+    std::vector<float> features;      // 绑定为ONNX输入，准备后不得改变大小
+    std::vector<float> prediction;    // 绑定为ONNX输出
+    cv::Mat gray;                     // 检测和关键点使用的8位灰度图，尺寸不变时复用
+    std::vector<DetectedFace> detections;
+    int detection_rung = -1;          // 最近一帧命中的检测阶梯级，未检测到人脸为-1
+    double landmark_ms = 0.0;         // 最近一帧关键点回归耗时
+    
+    // 关键点跟踪状态（每个视频流一个工作区；切换视频流时清空previous_landmarks）
+    std::vector<cv::Point2f> previous_landmarks;
+    cv::Rect previous_face;
+    int tracked_frames = 0;           // 连续热启动的帧数
+    int first_cascade = 0;            // 最近一帧从第几级级联开始，0为完整回归
+#ifdef ONNX_AVAILABLE
+    std::vector<int64_t> input_shape;
+    std::vector<int64_t> output_shape;
+    Ort::Value input_tensor{nullptr};
+    Ort::Value output_tensor{nullptr};
+#endif
+    uint64_t model_generation = 0;    // 绑定张量时的模型代数，热重载后首帧重新绑定
+    bool prepared = false;
 };
 
 class EmotionAnalyzer {
 public:
+    // 模型能力: initialize时声明的能力立即加载，其余在首次使用时加载
+    enum Capability : unsigned {
+        DETECT     = 1u << 0,  // 人脸检测器
+        LANDMARKS  = 1u << 1,  // 68点形状预测器（约95MB）
+        FRONTALIZE = 1u << 2,  // 正面化权重
+        INFER      = 1u << 3,  // ONNX情绪模型
+        ALL        = DETECT | LANDMARKS | FRONTALIZE | INFER
+    };
+    
+    // 模型通过ModelRegistry在进程内共享: 使用相同模型文件的分析器复用已加载的只读模型，
+    // 后续实例只分配各自的检测器和配置
     EmotionAnalyzer(const std::string& onnx_model_path,
                    const std::string& frontalization_model_path,
                    const std::string& shape_predictor_path);
     
     ~EmotionAnalyzer();
     
-    // 初始化模型
-    bool initialize();
+    // 初始化模型: 立即加载声明的能力，例如只从关键点打分的服务可用 FRONTALIZE | INFER
+    bool initialize(unsigned capabilities = ALL);
+    
+    // 确保指定能力的模型已加载（并行加载，线程安全，每个模型只加载一次），全部可用时返回true
+    bool ensureCapabilities(unsigned capabilities);
+    
+    // 最近一次初始化失败的汇总信息（全部失败的模型）
+    const std::string& getInitializationError() const;
+    
+    // 当前已成功加载的能力
+    unsigned loadedCapabilities() const;
     
     // 从图像中分析情感
     EmotionResult analyzeEmotion(const cv::Mat& image);
     
+    // 同上，并通过landmarks_data返回检测到的关键点（图像坐标）
+    EmotionResult analyzeEmotion(const cv::Mat& image, LandmarksData& landmarks_data);
+    
+    // 转换为检测器和形状预测器使用的8位灰度图: 单通道直接复制，BGR/BGRA取 (b+g+r)/3，
+    // 与dlib对彩色像素求强度的方式一致；不支持的格式返回false
+    static bool toGray(const cv::Mat& image, cv::Mat& gray);
+    
+    // 为工作区预分配缓冲区并绑定ONNX张量
+    bool prepareWorkspace(AnalysisWorkspace& workspace);
+    
+    // 工作区版本的情感分析，结果写入result（复用其字符串容量）；未检测到人脸时返回false。
+    // 人脸检测仍会逐帧分配（dlib的HOG金字塔和检测结果列表），检测之后的阶段不分配；
+    // 需要零堆分配时由调用方提供人脸框，使用下面的重载
+    bool analyzeEmotion(const cv::Mat& image, AnalysisWorkspace& workspace, EmotionResult& result);
+    
+    // 同上，但跳过人脸检测，在调用方给出的人脸框上回归关键点；稳态下零堆分配（内置求值器）
+    bool analyzeEmotion(const cv::Mat& image, const cv::Rect& face, AnalysisWorkspace& workspace,
+                        EmotionResult& result);
+    
+    // 从已有的68个原始关键点开始分析（特征、推理、标签），稳态下零堆分配
+    bool analyzeLandmarks(const std::vector<cv::Point2f>& raw_landmarks,
+                          AnalysisWorkspace& workspace, EmotionResult& result);
+    
+    // 在调用方提供的人脸框上分析: 跳过人脸检测，直接运行形状预测器，
+    // 所有人脸的特征合并为一次批量推理；返回与rects一一对应的结果
+    std::vector<FaceEmotion> analyzeFacesInRects(const cv::Mat& image, const std::vector<cv::Rect>& rects);
+    
+    // 预热: 用typical_size大小的合成帧运行工作区路径（检测、关键点、预绑定张量的推理）和人脸框批量推理，
+    // 使ORT内核、dlib图像金字塔和模型页缓存在首个真实请求前就绪；相邻两轮耗时变化在10%以内视为稳态。
+    // 传入workspace时同时为其分配缓冲区并绑定张量（结束时清空其跟踪状态）
+    WarmupReport warmup(int iterations, cv::Size typical_size, AnalysisWorkspace* workspace = nullptr);
+    
+    // 人脸检测配置（后端、最小/最大人脸、金字塔比例、阈值、上采样），检测器加载前后均可设置；
+    // 更换后端时重新创建检测器，失败则保留原检测器。与检测并发调用不安全
+    void setDetectorConfig(const DetectorConfig& config);
+    const DetectorConfig& getDetectorConfig() const;
+    
+    // 按当前配置检测人脸，结果按置信度降序
+    std::vector<DetectedFace> detectFaces(const cv::Mat& image);
+    
+    // 当前检测器后端名称与累计检测耗时（检测器未加载时为空）
+    std::string getDetectorName() const;
+    DetectorStats getDetectorStats() const;
+    
+    // 关键点回归使用内置ERT求值器（默认）还是dlib的shape_predictor；须在关键点模型加载前设置，
+    // 内置求值器加载失败时自动退回dlib
+    void setNativeShapePredictor(bool enabled);
+    
+    // 关键点快速模式: 只运行前K级级联和/或每级前N棵树（仅内置求值器支持，dlib回退时忽略）；
+    // 与分析并发调用不安全
+    void setLandmarkBudget(const ErtBudget& budget);
+    const ErtBudget& getLandmarkBudget() const;
+    
+    // 视频关键点跟踪（仅工作区版本的analyzeEmotion，需要内置求值器）；与分析并发调用不安全
+    void setLandmarkTracking(const LandmarkTracking& tracking);
+    const LandmarkTracking& getLandmarkTracking() const;
+    
+    // ONNX图优化级别与优化模型缓存，在下一次加载ONNX模型（首次使用或热重载）时生效
+    void setOnnxSessionConfig(const OnnxSessionConfig& config);
+    const OnnxSessionConfig& getOnnxSessionConfig() const;
+    
     // 获取面部关键点
     LandmarksData getFacialLandmarks(const cv::Mat& image);
     
     // 正面化关键点
     std::vector<cv::Point2f> frontalizeLandmarks(const std::vector<cv::Point2f>& landmarks);
     
+    // 批量正面化: 将N个人脸的特征行堆叠成 N x 137 矩阵，用一次分块GEMM完成
+    std::vector<std::vector<cv::Point2f>> frontalizeLandmarksBatch(
+        const std::vector<std::vector<cv::Point2f>>& landmarks_batch);
+    
     // 提取几何特征
     std::vector<float> extractGeometricFeatures(const std::vector<cv::Point2f>& landmarks);
     
+    // 融合特征提取: 从原始关键点一次完成标准化、正面化和距离特征，
+    // 直接写入调用方提供的缓冲区，返回写入的特征数（失败返回0）
+    int extractFeaturesFused(const std::vector<cv::Point2f>& raw_landmarks,
+                             float* features, size_t capacity);
+    
     // 使用ONNX模型进行预测
     std::vector<float> predictWithONNX(const std::vector<float>& features);
     
+    // 批量预测: features为 batch_size x feature_dim 的行主序矩阵，返回按行排列的模型输出
+    std::vector<float> predictWithONNXBatch(const float* features, size_t batch_size, size_t feature_dim);
+    
     // 将AVI值转换为情感名称
     std::string aviToEmotionName(float arousal, float valence, float intensity = -1.0f);
+    
+    // 将AVI值转换为情感名称，写入已有字符串（容量足够时不分配）
+    void aviToEmotionName(float arousal, float valence, float intensity, std::string& emotion_name);
+    
+    // 热重载（RCU）: 在调用线程加载新模型并预热，全部成功后原子替换模型快照。进行中的请求在旧模型上
+    // 完成，之后的请求使用新模型，分析无需停止；旧模型随最后一个请求释放。空路径表示保留当前模型，
+    // 任一模型加载失败时不做替换并返回false。可与分析并发调用，多个重载串行执行。
+    // 初始化时加载失败的模型也可由重载恢复，之后依赖该模型的分析路径正常工作
+    bool reloadModels(const std::string& onnx_model_path,
+                      const std::string& frontalization_model_path = "",
+                      const std::string& shape_predictor_path = "");
+    
+    // 模型代数: 初始为0，每次成功热重载加1
+    uint64_t modelGeneration() const;
 
 private:
+    // 按需加载的模型状态，失败后不重试
+    struct LazyModel {
+        std::once_flag once;
+        std::atomic<bool> loaded{false};
+        double load_ms = 0.0;   // 加载耗时，由call_once发布
+    };
+    
     // 私有成员变量
     std::string onnx_model_path_;
     std::string frontalization_model_path_;
     std::string shape_predictor_path_;
     
+    // 一起发布的一组只读模型（由ModelRegistry在进程内共享，分析器只持有引用）。
+    // 发布后不再修改: 每个请求开始时取一次快照，热重载和首次加载都通过替换整个快照生效
+    struct ModelSet {
 #ifdef ONNX_AVAILABLE
-    // ONNX Runtime相关
-    std::unique_ptr<Ort::Env> ort_env_;
-    std::unique_ptr<Ort::Session> ort_session_;
-    std::unique_ptr<Ort::SessionOptions> session_options_;
-    
-    // ONNX 输入输出名称
-    std::string input_name_;
-    std::string output_name_;
+        std::shared_ptr<const OnnxModel> onnx;
 #endif
+        std::shared_ptr<const FrontalizationModel> frontalization;
+        std::shared_ptr<const ErtShapePredictor> ert;
+#ifdef DLIB_AVAILABLE
+        std::shared_ptr<const dlib::shape_predictor> dlib_shape;
+#endif
+        uint64_t generation = 0;
+    };
+    
+    std::shared_ptr<const ModelSet> models_;   // 只通过std::atomic_load/atomic_store访问
+    std::mutex models_mutex_;                  // 串行化快照发布，保护模型路径
+    std::mutex reload_mutex_;                  // 串行化热重载
     
-    // 模型参数
-    std::vector<float> frontalization_weights_; // Flattened 137x136 matrix
     bool full_features_;
     int components_;
     
-#ifdef DLIB_AVAILABLE
-    // dlib相关
-    dlib::frontal_face_detector face_detector_;
-    dlib::shape_predictor shape_predictor_;
-#endif
+    std::unique_ptr<FaceDetector> face_detector_;
+    
+    bool native_shape_predictor_ = true;
+    ErtBudget landmark_budget_;
+    LandmarkTracking landmark_tracking_;
+    OnnxSessionConfig onnx_session_config_;
+    
+    DetectorConfig detector_config_;
+    LazyModel detector_state_;
+    LazyModel shape_predictor_state_;
+    LazyModel frontalization_state_;
+    LazyModel onnx_state_;
+    std::string initialization_error_;
     
     // 私有方法
+    bool loadFaceDetector();
     bool loadFrontalizationModel();
     bool loadONNXModel();
     bool loadShapePredictor();
     
+    // 从给定路径构建模型（经ModelRegistry共享），失败返回nullptr
+#ifdef ONNX_AVAILABLE
+    std::shared_ptr<const OnnxModel> buildONNXModel(const std::string& path);
+#endif
+    std::shared_ptr<const FrontalizationModel> buildFrontalizationModel(const std::string& path);
+    bool buildShapePredictor(const std::string& path, ModelSet& models);
+    
+    // 当前模型快照（从不为空）
+    std::shared_ptr<const ModelSet> snapshot() const;
+    // 在models_mutex_下复制当前快照、修改后原子发布
+    void publish(const std::function<void(ModelSet&)>& update);
+    // 在models_mutex_下复制一个字符串成员（模型路径由热重载在同一把锁下修改）
+    std::string lockedCopy(const std::string& value);
+    
+    // 在灰度图的人脸框上回归关键点（内置求值器或dlib），写入landmarks
+    bool predictShape(const ModelSet& models, const cv::Mat& gray, const cv::Rect& face,
+                      std::vector<cv::Point2f>& landmarks) const;
+    
+    // 工作区的跟踪版本: 按运动量决定从上一帧热启动还是完整回归，并更新跟踪状态
+    bool trackShape(const ModelSet& models, const cv::Mat& gray, const cv::Rect& face,
+                    AnalysisWorkspace& workspace) const;
+    
+    // 使用给定快照的特征提取和批量推理
+    int extractFeaturesFused(const ModelSet& models, const std::vector<cv::Point2f>& raw_landmarks,
+                             float* features, size_t capacity);
+    std::vector<float> predictWithONNXBatch(const ModelSet& models, const float* features,
+                                            size_t batch_size, size_t feature_dim);
+    
+    // 首次使用时加载对应模型
+    bool ensureModel(LazyModel& model, bool (EmotionAnalyzer::*load)());
+    bool ensureDetector();
+    bool ensureShapePredictor();
+    bool ensureFrontalization();
+    bool ensureONNX();
+    
+    // 工作区路径的各阶段
+    bool bindWorkspace(AnalysisWorkspace& workspace, const ModelSet& models);
+    bool analyzeWorkspace(const cv::Mat& image, const cv::Rect* face, AnalysisWorkspace& workspace,
+                          EmotionResult& result);
+    bool detectLandmarks(const cv::Mat& gray, AnalysisWorkspace& workspace);
+    bool predictLandmarks(const cv::Mat& gray, const cv::Rect& face, AnalysisWorkspace& workspace);
+    bool runPrediction(const ModelSet& models, AnalysisWorkspace& workspace);
+    void fillEmotionResult(float arousal, float valence, EmotionResult& result);
+    
     // 几何特征提取的辅助函数
     float calculateDistance(const cv::Point2f& p1, const cv::Point2f& p2);
     float calculateScale(const std::vector<cv::Point2f>& landmarks, const std::vector<int>& landmark_indices);
@@ -0,0 +1,50 @@
+#pragma once
+
+// 基于Russell情绪环模型的情绪标签（与Python avi_to_text一致）
+namespace EmotionLabels {
+    constexpr int kNumSectors = 24;
+    constexpr int kNumIntensityLevels = 4;
+
+    // 特殊标签ID
+    constexpr int kLabelNeutral = -1;
+    constexpr int kLabelUnknown = -2;
+
+    // 情绪扇区: 角度theta（度，[0,360)）小于upper_bound且不属于前一扇区时命中
+    struct Sector {
+        float upper_bound;
+        const char* name;
+    };
+
+    // 按角度升序排列；theta > 354 回绕到 "pleased"
+    constexpr Sector kSectors[kNumSectors] = {
+        {16.0f, "pleased"}, {34.0f, "happy"}, {62.5f, "delighted"}, {78.5f, "excited"},
+        {93.0f, "astonished"}, {104.0f, "aroused"},                                  // first quarter
+        {115.0f, "tensed"}, {126.0f, "alarmed"}, {137.0f, "afraid"}, {148.0f, "annoyed"},
+        {159.0f, "distressed"}, {170.0f, "frustrated"}, {181.0f, "miserable"},        // second quarter
+        {192.0f, "sad"}, {203.0f, "gloomy"}, {215.0f, "depressed"}, {230.0f, "bored"},
+        {245.0f, "droopy"}, {260.0f, "tired"}, {280.0f, "sleepy"},                    // third quarter
+        {300.0f, "calm"}, {320.0f, "serene"}, {340.0f, "content"}, {354.0f, "satisfied"} // fourth quarter
+    };
+
+    // 强度等级: intensity < 0.1 为Neutral，其余按上界划分
+    constexpr float kNeutralThreshold = 0.1f;
+    constexpr float kIntensityUpperBounds[kNumIntensityLevels - 1] = {0.325f, 0.55f, 0.775f};
+    constexpr const char* kIntensityNames[kNumIntensityLevels] = {
+        "Slightly", "Moderately", "Very", "Extremely"
+    };
+
+    // 最长标签 "Moderately astonished" 的长度
+    constexpr int kMaxLabelLength = 21;
+
+    // 紧凑情绪编码: 扇区标签ID（0-23，或kLabelNeutral/kLabelUnknown）与强度等级（0-3，Neutral/Unknown为-1）
+    struct EmotionCode {
+        int quadrant_label_id;
+        int intensity_level;
+    };
+
+    // 将AVI值映射为情绪编码（查表，不分配内存）；intensity < 0 时由arousal/valence计算
+    EmotionCode fromAVI(float arousal, float valence, float intensity = -1.0f);
+
+    // 情绪编码对应的驻留标签，如 "Very happy"、"Neutral"；指针在进程生命周期内有效
+    const char* label(EmotionCode code);
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <opencv2/opencv.hpp>
+
+#include "mapped_file.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// 求值预算: 只运行前cascades级级联、每级前trees棵树（梯度提升中越靠前的树贡献越大），0表示全部。
+// 视频中相邻帧人脸变化小，截断的级联通常已足够
+struct ErtBudget {
+    int cascades = 0;
+    int trees = 0;
+
+    bool full() const { return cascades <= 0 && trees <= 0; }
+};
+
+// 集成回归树（ERT）关键点回归器: 读取dlib shape_predictor的.dat模型，或由saveFlat导出的扁平模型文件。
+// 模型整体是一块连续的扁平映像（平均形状、每级级联的锚点/偏移SoA、分裂节点和叶子数组，64字节对齐），
+// .dat在堆上构建该映像，扁平文件则只读映射（MAP_SHARED），同一主机上的多个进程共享同一份物理页。
+// 每级先一次采集全部像素特征，再遍历所有树得到叶子序号，最后按树的顺序沿形状维度累加叶子偏移
+// （SSE2/NEON，每16列的形状常驻4个向量寄存器遍历全部树）。累加顺序与dlib相同，坐标按dlib的规则取整
+class ErtShapePredictor {
+public:
+    ErtShapePredictor() = default;
+    ErtShapePredictor(ErtShapePredictor&&) = default;
+    ErtShapePredictor& operator=(ErtShapePredictor&&) = default;
+    ErtShapePredictor(const ErtShapePredictor&) = delete;
+    ErtShapePredictor& operator=(const ErtShapePredictor&) = delete;
+
+    // 加载模型: 扁平文件（按文件头识别）直接映射，否则按dlib序列化格式解析（需要dlib）；
+    // 失败返回false并保持原模型
+    bool load(const std::string& path);
+
+    // 把当前模型写为扁平文件，供其他进程映射加载
+    bool saveFlat(const std::string& path) const;
+
+    // 判断文件是否为扁平模型
+    static bool isFlatFile(const std::string& path);
+
+    bool empty() const { return cascades_.empty(); }
+    bool isMapped() const { return mapping_ != nullptr; }
+    size_t modelBytes() const { return image_size_; }
+    int numParts() const { return dim_ / 2; }
+    int numCascades() const { return static_cast<int>(cascades_.size()); }
+    int treesPerCascade() const { return cascades_.empty() ? 0 : cascades_[0].num_trees; }
+
+    // 在8位灰度图的face框上回归关键点，landmarks写入numParts()个点；budget限制运行的级联和树。
+    // 中间缓冲区按线程复用，可多线程并发调用，稳态下不分配堆内存
+    void predict(const cv::Mat& gray, const cv::Rect& face, std::vector<cv::Point2f>& landmarks,
+                 const ErtBudget& budget = ErtBudget()) const;
+
+    // 热启动: 从start（图像坐标的numParts()个点，如对齐到本帧人脸框的上一帧关键点）开始，
+    // 跳过前first_cascade级粗调级联。start点数不符时退回完整回归；start可与landmarks为同一对象
+    void predictFrom(const cv::Mat& gray, const cv::Rect& face, const std::vector<cv::Point2f>& start,
+                     int first_cascade, std::vector<cv::Point2f>& landmarks,
+                     const ErtBudget& budget = ErtBudget()) const;
+
+private:
+    // 分裂节点: 两个特征像素之差大于thresh时走左子树（2i+1），否则走右子树（2i+2）
+    struct Split {
+        uint16_t idx1;
+        uint16_t idx2;
+        float thresh;
+    };
+
+    // 一级级联，指向扁平映像内的数组
+    struct Cascade {
+        const int32_t* anchor = nullptr;   // 每个特征像素的锚点关键点
+        const float* delta_x = nullptr;    // 相对锚点的偏移（平均形状坐标系）
+        const float* delta_y = nullptr;
+        const Split* splits = nullptr;     // num_trees x splits_per_tree
+        const float* leaves = nullptr;     // num_trees x leaves_per_tree x 形状维度
+        int features = 0;
+        int num_trees = 0;
+    };
+
+    // start为空时从平均形状开始
+    void evaluate(const cv::Mat& gray, const cv::Rect& face, const std::vector<cv::Point2f>* start,
+                  int first_cascade, std::vector<cv::Point2f>& landmarks, const ErtBudget& budget) const;
+
+    bool loadDlib(const std::string& path);
+    bool loadFlat(const std::string& path);
+
+    // 校验扁平映像（范围、锚点和特征序号）并让各级级联指向其中的数组；不读取叶子
+    bool bind(const unsigned char* image, size_t size);
+
+    std::vector<uint64_t> owned_;               // 从.dat构建的映像（映射加载时为空）
+    std::unique_ptr<MappedFile> mapping_;       // 映射的扁平文件
+    const unsigned char* image_ = nullptr;
+    size_t image_size_ = 0;
+
+    const float* initial_shape_ = nullptr;  // 平均形状 [x0, y0, x1, y1, ...]，人脸框内的归一化坐标
+    int dim_ = 0;                           // 形状维度（2 x 关键点数）
+    std::vector<float> initial_centered_;   // 去中心化的平均形状，用于求相似变换
+    float initial_norm_ = 0.0f;             // initial_centered_的平方和
+    std::vector<Cascade> cascades_;
+    int splits_per_tree_ = 0;
+    int leaves_per_tree_ = 0;
+};
@@ -0,0 +1,214 @@
+#pragma once
+
+#include <opencv2/opencv.hpp>
+
+#ifdef DLIB_AVAILABLE
+#include <dlib/opencv.h>
+#include <dlib/image_processing/frontal_face_detector.h>
+#endif
+
+#include "worker_pool.h"
+
+#include <vector>
+#include <string>
+#include <memory>
+#include <functional>
+
+// 人脸检测后端
+enum class DetectorBackend {
+    Hog,        // dlib HOG正面人脸检测器（需要dlib）
+    Cascade     // OpenCV级联分类器（Haar/LBP，使用OpenCV自带的模型文件）
+};
+
+// 默认级联模型文件（构建时从OpenCV安装目录复制到输出目录）
+constexpr const char* kHaarCascadeFile = "haarcascade_frontalface_default.xml";
+constexpr const char* kLbpCascadeFile = "lbpcascade_frontalface_improved.xml";
+
+// 人脸检测配置；HOG后端全部为默认值时等同于dlib默认检测（不上采样、5/6金字塔、阈值0）
+struct DetectorConfig {
+#ifdef DLIB_AVAILABLE
+    DetectorBackend backend = DetectorBackend::Hog;
+#else
+    DetectorBackend backend = DetectorBackend::Cascade;
+#endif
+    std::string cascade_path = kHaarCascadeFile;  // Cascade后端的模型文件
+
+    int min_face_size = 0;               // 最小人脸边长（像素），0表示由upsample决定（80 / 2^upsample）
+    int max_face_size = 0;               // 最大人脸边长（像素），0表示不限
+    double pyramid_ratio = 5.0 / 6.0;    // 相邻金字塔层的缩放比例，(0, 1)
+    double threshold = 0.0;              // HOG检测阈值偏移，越大越严格
+    int upsample = 0;                    // 上采样次数（每次放大2倍），min_face_size > 0 时忽略
+    int min_neighbors = 3;               // Cascade后端: 保留一个框所需的相邻检测数
+    int threads = 0;                     // HOG后端的检测线程数，0为硬件线程数；小于640x480的图像始终单线程
+
+    // 分块检测（HOG后端）: 大于tile_size的图像切成相互重叠tile_overlap像素的块，各块独立构建金字塔
+    // 并行检测，跨块的重复框由非极大值抑制合并；检测工作内存由块大小而非图像大小决定。
+    // 跨越块边界且大于重叠宽度的人脸可能漏检。0表示不分块
+    int tile_size = 0;
+    int tile_overlap = 256;
+
+    // 检测阶梯: 按最小人脸尺寸从大到小依次检测，某一级检测到人脸即停止；
+    // 每级只扫描上一级未覆盖的金字塔层。启用时忽略min_face_size和upsample
+    bool ladder = false;
+    std::vector<int> ladder_min_faces = {160, 80, 40};
+
+    // 是否只需调整阈值，可直接使用dlib内置金字塔
+    bool usesBuiltinPyramid() const;
+};
+
+// 检测耗时统计
+struct DetectorStats {
+    long long calls = 0;
+    double total_ms = 0.0;
+    double last_ms = 0.0;
+
+    double meanMs() const { return calls > 0 ? total_ms / calls : 0.0; }
+};
+
+// 检测到的人脸框
+struct DetectedFace {
+    cv::Rect rect;
+    double confidence = 0.0;
+};
+
+namespace FaceDetection {
+    // dlib正面人脸检测器的检测窗口边长（像素）
+    constexpr int kWindowSize = 80;
+
+    // 达到此像素数的图像才多线程检测；更小的图像线程启动开销大于收益
+    constexpr int kParallelMinPixels = 640 * 480;
+
+    // 金字塔层按行切分为条带时相邻条带的重叠行数: 检测窗口加两个HOG单元，
+    // 保证任一窗口完整落在某个条带内
+    constexpr int kStripOverlap = kWindowSize + 16;
+
+    // 按配置和图像大小确定的检测线程数
+    int detectionThreads(cv::Size image_size, const DetectorConfig& config);
+
+    // 两个框的交并比
+    double intersectionOverUnion(const cv::Rect& a, const cv::Rect& b);
+
+    // 非极大值抑制: 按置信度降序保留，与已保留框交并比超过iou_threshold的框被丢弃
+    void nonMaxSuppression(std::vector<DetectedFace>& faces, double iou_threshold = 0.5);
+
+    // 按配置生成的金字塔缩放比例（相对原图，降序）
+    std::vector<double> pyramidScales(cv::Size image_size, const DetectorConfig& config);
+
+#ifdef DLIB_AVAILABLE
+    inline dlib::rectangle toDlibRect(const cv::Rect& r) {
+        return dlib::rectangle(r.x, r.y, r.x + r.width - 1, r.y + r.height - 1);
+    }
+#endif
+}
+
+// 人脸检测器接口: detect统一计时，各后端实现detectImpl
+class FaceDetector {
+public:
+    virtual ~FaceDetector() = default;
+
+    // 后端名称，如 "dlib-hog"、"opencv-cascade"
+    virtual const char* name() const = 0;
+
+    virtual void setConfig(const DetectorConfig& config) { config_ = config; }
+    const DetectorConfig& config() const { return config_; }
+
+    // 在8位灰度图上检测，结果按置信度降序写入faces；返回命中的阶梯级
+    // （未启用阶梯时为0），未检测到人脸返回-1。同一实例不可并发调用
+    int detect(const cv::Mat& gray, std::vector<DetectedFace>& faces);
+
+    const DetectorStats& stats() const { return stats_; }
+    void resetStats() { stats_ = DetectorStats(); }
+
+protected:
+    virtual int detectImpl(const cv::Mat& gray, std::vector<DetectedFace>& faces) = 0;
+
+    DetectorConfig config_;
+
+private:
+    DetectorStats stats_;
+};
+
+#ifdef DLIB_AVAILABLE
+// dlib HOG人脸检测器: 默认配置且单线程时直接调用dlib；否则按配置自建金字塔，
+// 每层用单层扫描的检测器运行，再缩放回原图坐标并做非极大值抑制。
+// 多线程时各层（大层再按行切成重叠条带）分发给各线程，每个线程使用自己的检测器副本
+class HogFaceDetector : public FaceDetector {
+public:
+    HogFaceDetector();
+
+    const char* name() const override { return "dlib-hog"; }
+
+protected:
+    int detectImpl(const cv::Mat& gray, std::vector<DetectedFace>& faces) override;
+
+private:
+    std::shared_ptr<const dlib::frontal_face_detector> prototype_;  // 注册表共享的检测器，只反序列化一次
+    dlib::frontal_face_detector detector_;        // dlib内置金字塔
+    dlib::frontal_face_detector single_level_;    // 同一组权重，只扫描输入图像本身
+    std::vector<dlib::rect_detection> scratch_;   // 复用的检测缓冲区（dlib扫描时保存内部状态）
+    std::vector<double> scales_;                  // 复用的金字塔比例
+    cv::Mat level_;                               // 复用的金字塔层图像
+
+    // 多线程检测: 每个线程一个检测器副本（dlib检测器不可并发调用）和结果缓冲区
+    struct Worker {
+        dlib::frontal_face_detector detector;
+        std::vector<dlib::rect_detection> scratch;
+        std::vector<DetectedFace> faces;
+        cv::Mat level;                            // 分块模式下当前块的金字塔层
+    };
+    // 一个扫描任务: 某一金字塔层上的一个条带，或分块模式下原图的一个块
+    struct ScanTask {
+        size_t level;
+        cv::Rect roi;
+    };
+    std::vector<Worker> workers_;
+    WorkerPool pool_;                             // 常驻线程，逐帧复用
+    std::vector<cv::Mat> levels_;                 // 各金字塔层图像（比例为1的层直接使用原图）
+    std::vector<ScanTask> tasks_;
+
+    // 在给定比例的各层上检测，结果追加到faces（未做非极大值抑制）
+    void detectLevels(const cv::Mat& gray, const std::vector<double>& scales, std::vector<DetectedFace>& faces);
+    void detectLevelsParallel(const cv::Mat& gray, const std::vector<double>& scales, int threads,
+                              std::vector<DetectedFace>& faces);
+    void detectTiles(const cv::Mat& gray, const std::vector<double>& scales, int threads,
+                     std::vector<DetectedFace>& faces);
+
+    // 用threads个工作线程执行tasks_，各线程的结果追加到faces
+    void runTasks(int threads, std::vector<DetectedFace>& faces,
+                  const std::function<void(Worker&, const ScanTask&)>& scan);
+
+    static void resizeLevel(const cv::Mat& image, double scale, cv::Mat& level);
+    // 把某一层（偏移offset处）的检测框缩放回原图坐标，追加到faces
+    static void appendDetections(const std::vector<dlib::rect_detection>& detections, cv::Point offset,
+                                 double scale, std::vector<DetectedFace>& faces);
+};
+#endif
+
+// OpenCV级联分类器人脸检测器: min/max_face_size、pyramid_ratio和阶梯映射到detectMultiScale的
+// minSize/maxSize/scaleFactor，置信度为相邻检测数；不使用threshold
+class CascadeFaceDetector : public FaceDetector {
+public:
+    // 加载失败时返回false
+    bool load(const std::string& cascade_path);
+
+    const char* name() const override { return "opencv-cascade"; }
+
+protected:
+    int detectImpl(const cv::Mat& gray, std::vector<DetectedFace>& faces) override;
+
+private:
+    cv::CascadeClassifier classifier_;
+    std::vector<cv::Rect> objects_;
+    std::vector<int> neighbors_;
+
+    // 在[min_size, max_size)范围内检测，结果追加到faces
+    void detectRange(const cv::Mat& gray, int min_size, int max_size, std::vector<DetectedFace>& faces);
+};
+
+namespace FaceDetection {
+    // 按配置创建检测器后端，失败时返回nullptr并写入error
+    std::unique_ptr<FaceDetector> create(const DetectorConfig& config, std::string& error);
+
+    // 解析后端名称: "hog"、"haar"、"lbp"，或级联模型文件路径（.xml）；无法识别返回false
+    bool parseBackend(const std::string& name, DetectorConfig& config);
+}
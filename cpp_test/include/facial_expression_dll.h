@@ -26,6 +26,52 @@ typedef struct {
     char error_message[256];
 } EmotionResultDLL;
 
+// 紧凑情绪分析结果（无字符串缓冲区，按值返回只有24字节）
+// 标签通过 GetEmotionLabel(label_id, intensity_level) 查询，调用方可按ID缓存
+typedef struct {
+    float arousal;
+    float valence;
+    float intensity;
+    int label_id;         // 扇区标签 0-23，-1 为Neutral，-2 为Unknown
+    int intensity_level;  // 0-3 (Slightly/Moderately/Very/Extremely)，Neutral时为-1
+    int success;          // 失败原因见 GetLastError
+} EmotionResultCompactDLL;
+
+// 人脸框（图像坐标）
+typedef struct {
+    int x;
+    int y;
+    int width;
+    int height;
+} FaceRectDLL;
+
+// 人脸检测配置，字段含义同C++端 DetectorConfig；全零（pyramid_ratio为0时取5/6）即dlib默认检测
+typedef struct {
+    int min_face_size;     // 最小人脸边长（像素），0为默认
+    int max_face_size;     // 最大人脸边长（像素），0为不限
+    double pyramid_ratio;  // 金字塔相邻层缩放比例 (0, 1)
+    double threshold;      // 检测阈值偏移，越大越严格
+    int upsample;          // 上采样次数
+    int ladder;            // 非0时启用检测阶梯（最小人脸160/80/40，未检测到才继续下一级）
+    const char* backend;   // "hog"、"haar"、"lbp" 或级联模型文件路径；NULL或空串为默认（有dlib时为hog）
+    int threads;           // HOG检测线程数，0为硬件线程数（640x480以下的图像始终单线程）
+    int tile_size;         // 分块检测的块边长，0为不分块
+    int tile_overlap;      // 相邻块的重叠像素，0时取默认值256
+} DetectorConfigDLL;
+
+// YUV 4:2:0 帧格式
+#define FRAME_FORMAT_NV12 0  // Y平面 + 交错的UV平面
+#define FRAME_FORMAT_I420 1  // Y、U、V三个平面
+
+// 相机YUV帧: 各平面指针与行跨度（字节）。检测和关键点直接使用Y平面，色度平面不参与分析，可为NULL
+typedef struct {
+    const unsigned char* planes[3];  // NV12: Y, UV；I420: Y, U, V
+    int strides[3];
+    int width;
+    int height;
+    int format;                      // FRAME_FORMAT_NV12 或 FRAME_FORMAT_I420
+} YUVFrameDLL;
+
 // DLL接口函数声明
 FACIAL_EXPRESSION_API int __cdecl InitializeEmotionAnalyzer(
     const char* onnx_model_path,
@@ -35,6 +81,7 @@ FACIAL_EXPRESSION_API int __cdecl InitializeEmotionAnalyzer(
 
 FACIAL_EXPRESSION_API EmotionResultDLL __cdecl AnalyzeEmotionFromFile(const char* image_path);
 
+// width/height/channels > 0 时为原始像素（1通道灰度、3通道BGR、4通道BGRA，行间无填充），否则为编码图像
 FACIAL_EXPRESSION_API EmotionResultDLL __cdecl AnalyzeEmotionFromBytes(
     const unsigned char* image_data,
     int data_length,
@@ -43,6 +90,71 @@ FACIAL_EXPRESSION_API EmotionResultDLL __cdecl AnalyzeEmotionFromBytes(
     int channels
 );
 
+// 紧凑版本: 复用内部工作区，只返回数值和标签编码
+FACIAL_EXPRESSION_API EmotionResultCompactDLL __cdecl AnalyzeEmotionFromFileCompact(const char* image_path);
+
+FACIAL_EXPRESSION_API EmotionResultCompactDLL __cdecl AnalyzeEmotionFromBytesCompact(
+    const unsigned char* image_data,
+    int data_length,
+    int width,
+    int height,
+    int channels
+);
+
+// YUV帧输入: 不做颜色转换和拷贝，直接在Y平面上检测人脸和关键点；与紧凑接口共用同一工作区（含关键点跟踪）
+FACIAL_EXPRESSION_API EmotionResultDLL __cdecl AnalyzeEmotionFromYUVFrame(const YUVFrameDLL* frame);
+
+FACIAL_EXPRESSION_API EmotionResultCompactDLL __cdecl AnalyzeEmotionFromYUVFrameCompact(const YUVFrameDLL* frame);
+
+// 在调用方提供的人脸框上分析情绪（跳过人脸检测），所有人脸一次批量推理
+// 图像参数同 AnalyzeEmotionFromBytes；results须有num_rects个元素，逐框设置success
+// 返回成功分析的人脸数，参数错误或未初始化返回-1
+FACIAL_EXPRESSION_API int __cdecl AnalyzeEmotionInRects(
+    const unsigned char* image_data,
+    int data_length,
+    int width,
+    int height,
+    int channels,
+    const FaceRectDLL* rects,
+    int num_rects,
+    EmotionResultCompactDLL* results
+);
+
+// 设置人脸检测配置，初始化前后均可调用，之后的分析生效；参数无效返回0
+// 更换后端时若新后端加载失败，继续使用原检测器（见控制台输出）
+FACIAL_EXPRESSION_API int __cdecl SetDetectorConfig(const DetectorConfigDLL* config);
+
+// 关键点快速模式: 只运行前cascades级级联、每级前trees棵树，0表示全部（默认完整模型）；
+// 初始化前后均可调用，不可与分析并发调用。参数为负返回0
+FACIAL_EXPRESSION_API int __cdecl SetLandmarkBudget(int cascades, int trees);
+
+// 视频关键点跟踪: 非0时紧凑接口和YUV帧接口从上一帧关键点热启动，人脸运动小时跳过粗调级联；
+// 适用于同一路视频流的连续帧。初始化前后均可调用，不可与分析并发调用
+FACIAL_EXPRESSION_API void __cdecl SetLandmarkTracking(int enabled);
+
+// ONNX图优化级别（0关闭, 1基本, 2扩展（默认）, 3全部）与优化模型缓存目录: 首次加载时把优化后的模型写入缓存，
+// 之后的进程直接加载并跳过图优化。cache_dir为NULL使用当前用户的缓存目录（%LOCALAPPDATA%\emotion_ort_cache），""表示不缓存。
+// 在初始化前调用，或之后配合 ReloadEmotionModels 生效；级别无效返回0
+FACIAL_EXPRESSION_API int __cdecl SetOnnxSessionOptions(int optimization_level, const char* cache_dir);
+
+// 设置文件/编码字节输入的降分辨率解码目标长边（默认1280）；大图按1/2、1/4、1/8解码，0表示始终全分辨率
+FACIAL_EXPRESSION_API void __cdecl SetDecodeMaxSide(int max_side);
+
+// 预热: 用 width x height 的合成帧运行iterations轮完整流程，消除首次调用的延迟尖峰
+// 返回达到稳态的轮次（>0），运行完成但未达到稳态返回0，失败返回-1（见 GetLastError）
+FACIAL_EXPRESSION_API int __cdecl WarmupEmotionAnalyzer(int iterations, int width, int height);
+
+// 热重载: 加载并预热新模型后原子替换，进行中的分析在旧模型上完成，无需停止分析。NULL表示保留当前模型；
+// 可与分析并发调用。任一模型加载失败时保留原模型并返回0（见 GetLastError），成功返回1
+FACIAL_EXPRESSION_API int __cdecl ReloadEmotionModels(
+    const char* onnx_model_path,
+    const char* shape_predictor_path,
+    const char* frontalization_model_path
+);
+
+// 标签编码对应的完整标签，如 "Very happy"；返回的指针在进程生命周期内有效，无需释放
+FACIAL_EXPRESSION_API const char* __cdecl GetEmotionLabel(int label_id, int intensity_level);
+
 FACIAL_EXPRESSION_API void __cdecl ReleaseEmotionAnalyzer();
 
 FACIAL_EXPRESSION_API const char* __cdecl GetLastError();
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <opencv2/opencv.hpp>
+#include <string>
+#include <vector>
+
+// 降分辨率解码: 根据文件头中的图像尺寸和目标长边选择 IMREAD_REDUCED_COLOR_2/4/8，
+// JPEG在DCT域直接缩放，避免先解码全分辨率再由检测器缩小
+namespace ImageDecode {
+    // 默认目标长边；检测器对更大的图像并不会得到更多有效信息
+    constexpr int kDefaultTargetMaxSide = 1280;
+
+    struct DecodedImage {
+        cv::Mat image;             // 解码后的BGR图像（可能已缩小）
+        cv::Size original_size;    // 原图尺寸（与image方向一致）
+        int reduction = 1;         // 缩小倍数: 1, 2, 4 或 8
+    };
+
+    // 从JPEG/PNG文件头读取图像尺寸，不解码像素；未知格式返回false
+    bool readImageSize(const unsigned char* data, size_t length, cv::Size& size);
+
+    // 选择缩小倍数: 缩小后长边仍不小于target_max_side的最大倍数；target_max_side <= 0 时不缩小
+    int chooseReduction(cv::Size original_size, int target_max_side);
+
+    // 按策略解码文件/内存中的编码图像，失败时image为空
+    DecodedImage decodeFile(const std::string& path, int target_max_side = kDefaultTargetMaxSide);
+    DecodedImage decodeBytes(const unsigned char* data, size_t length,
+                             int target_max_side = kDefaultTargetMaxSide);
+
+    // 将解码图像上的坐标映射回原图坐标
+    void mapToOriginal(std::vector<cv::Point2f>& points, const DecodedImage& decoded);
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+
+// 关键点数值内核（不依赖OpenCV，使用裸float数组）
+namespace LandmarkKernels {
+    // 正面化模型维度: weights (137, 136) = (2*68 + 1, 2*68)
+    constexpr int kNumLandmarks = 68;
+    constexpr int kFrontalInputDim = 2 * kNumLandmarks + 1;  // 137，含截距项
+    constexpr int kFrontalOutputDim = 2 * kNumLandmarks;     // 136
+
+    // GEMM微内核的寄存器分块大小
+    constexpr int kMicroRows = 4;   // MR
+    constexpr int kMicroCols = 8;   // NR
+    // M方向的缓存分块（行数），A块约 64*137*4 = 35KB，与打包后的权重一起驻留L2
+    constexpr int kBlockRows = 64;  // MC
+
+    // 将行主序的 K x N 权重打包为宽度为NR的列面板:
+    // packed[panel][k][0..NR) = weights[k][panel*NR + 0..NR)，N不足NR的部分补零
+    std::vector<float> packWeightPanels(const float* weights, int k, int n);
+
+    // C(m x n) = A(m x k) * B(k x n)，A/C为行主序，B为packWeightPanels的输出
+    void gemmPacked(int m, int n, int k,
+                    const float* a, int lda,
+                    const float* b_packed,
+                    float* c, int ldc);
+
+    // C(m x n) = A(m x k) * B(k x n)，B为未打包的行主序矩阵（OpenBLAS可用时使用cblas_sgemm）
+    void gemm(int m, int n, int k,
+              const float* a, int lda,
+              const float* b, int ldb,
+              float* c, int ldc);
+
+    // 是否链接了OpenBLAS
+    bool blasAvailable();
+
+    // ---- 融合特征内核: 原始关键点 -> 模型特征向量 ----
+    // 关键点均为交错存储的 [x0, y0, x1, y1, ...]，共68个点
+
+    // 距离特征数: full_features 使用全部68点 (2278)，否则使用0-50点 (1275，与Python一致)
+    constexpr int featureCount(bool full_features) {
+        return full_features ? (68 * 67 / 2) : (51 * 50 / 2);
+    }
+    constexpr int kMaxFeatureCount = 68 * 67 / 2;
+
+    // Procrustes标准化（平移、缩放、按双眼连线旋转）并写入正面化输入行:
+    // row = [x1..x68, y1..y68, 1]，长度137。旋转直接由归一化的双眼向量得到，不调用三角函数
+    void standardizeToFeatureRow(const float* landmarks_xy, float* row);
+
+    // frontal(136) = row(137) * weights(137 x 136)，结果为 [x1..x68, y1..y68]
+    void frontalizeRow(const float* row, const float* weights, float* frontal);
+
+    // 由正面化后的关键点计算按尺度归一化的两两距离，返回写入的特征数
+    int pairwiseDistanceFeatures(const float* frontal, bool full_features, float* features);
+
+    // 完整融合流程，全部中间量在栈上，不分配堆内存；features至少容纳featureCount(full_features)个float
+    int computeModelFeatures(const float* landmarks_xy, const float* weights,
+                             bool full_features, float* features);
+}
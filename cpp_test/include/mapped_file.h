@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+// 只读内存映射文件: POSIX为mmap(PROT_READ, MAP_SHARED)，Windows为只读的文件映射视图。
+// 映射的页属于系统页缓存，映射同一文件的所有进程共享同一份物理内存，页在首次访问时才读入
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // 映射整个文件，失败返回false并输出原因；已映射时先解除
+    bool open(const std::string& path);
+    void close();
+
+    bool isOpen() const { return data_ != nullptr; }
+    const unsigned char* data() const { return data_; }
+    size_t size() const { return size_; }
+
+private:
+    const unsigned char* data_ = nullptr;
+    size_t size_ = 0;
+#ifdef _WIN32
+    void* file_ = nullptr;      // HANDLE
+    void* mapping_ = nullptr;   // HANDLE
+#endif
+};
@@ -15,11 +15,44 @@ struct ComparisonResult {
     std::string error_message;
 };
 
+// 黄金回归数据（由 generate_golden_fixtures.py 从 source/emotions_dlib.py 生成），按阶段连续存储
+struct GoldenFixtures {
+    int num_cases = 0;
+    int feature_dim = 0;
+    bool full_features = false;
+    std::vector<float> raw_landmarks;   // num_cases x 136，交错的 x, y
+    std::vector<float> standardized;    // num_cases x 137，[x1..x68, y1..y68, 1]
+    std::vector<float> frontal;         // num_cases x 136，[x1..x68, y1..y68]
+    std::vector<float> features;        // num_cases x feature_dim
+    std::vector<float> prediction;      // num_cases x 2，模型原始输出 (arousal, valence)
+    std::vector<float> avi;             // num_cases x 3，取整并截断后的 (arousal, valence, intensity)
+    std::vector<int> label_id;
+    std::vector<int> intensity_level;
+};
+
+// 单个阶段的比对结果
+struct GoldenStageResult {
+    std::string stage;
+    float tolerance;
+    float max_difference;
+    float mean_difference;
+    int failed_cases;   // 最大误差超过容差的样本数
+    bool passed;
+};
+
+struct GoldenParityResult {
+    bool success;
+    int num_cases;
+    double elapsed_ms;
+    std::vector<GoldenStageResult> stages;
+    std::string error_message;
+};
+
 class ModelComparison {
 public:
     ModelComparison(std::shared_ptr<EmotionAnalyzer> analyzer);
     
-    // 与Python joblib模型比较
+    // 与Python joblib模型比较（需要Python运行时，日常回归请使用runGoldenParityTest）
     ComparisonResult compareWithPythonModel(const std::string& python_script_path,
                                           const std::vector<std::string>& test_images);
     
@@ -27,6 +60,22 @@ public:
     ComparisonResult testRandomInputConsistency(int num_samples = 10, 
                                               int feature_dims = 1275);
     
+    // 测试批量正面化与逐个人脸正面化的一致性
+    ComparisonResult testBatchFrontalizationConsistency(int num_faces = 64);
+    
+    // 测试融合特征内核与分步实现（正面化+几何特征）的一致性
+    ComparisonResult testFusedFeatureConsistency(int num_faces = 64);
+    
+    // 加载黄金回归数据，失败时返回false并写入error
+    static bool loadGoldenFixtures(const std::string& fixture_path, GoldenFixtures& fixtures,
+                                   std::string& error);
+    
+    // 黄金回归测试: 在进程内逐阶段（标准化、正面化、特征、推理、标签）与Python参考输出比对
+    GoldenParityResult runGoldenParityTest(const std::string& fixture_path);
+    
+    // 生成黄金回归测试报告
+    std::string generateGoldenReport(const GoldenParityResult& result);
+    
     // 加载Python预测结果
     std::vector<std::vector<float>> loadPythonPredictions(const std::string& results_file);
     
@@ -43,7 +92,8 @@ public:
     std::string generateReport(const ComparisonResult& result);
     
     // 运行完整的模型验证测试
-    bool runFullValidationTest(const std::string& output_dir);
+    bool runFullValidationTest(const std::string& output_dir,
+                               const std::string& fixture_path = "../data/golden/golden_fixtures.bin");
 
 private:
     std::shared_ptr<EmotionAnalyzer> analyzer_;    
@@ -52,6 +102,13 @@ private:
                            const std::vector<std::string>& args);
     
     std::vector<float> generateRandomFeatureVector(int dims);
+    std::vector<cv::Point2f> generateRandomLandmarks();
+    
+    // 按样本比对一个阶段的输出（actual/expected均为 num_cases x dim）
+    GoldenStageResult compareGoldenStage(const std::string& stage, float tolerance,
+                                         const std::vector<float>& actual,
+                                         const std::vector<float>& expected,
+                                         int num_cases, int dim);
 
 public:
     void printComparisonResults(const ComparisonResult& result);
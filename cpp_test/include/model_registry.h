@@ -0,0 +1,72 @@
+#pragma once
+
+#ifdef DLIB_AVAILABLE
+#include <dlib/image_processing/frontal_face_detector.h>
+#endif
+
+#ifdef ONNX_AVAILABLE
+#include <onnxruntime_cxx_api.h>
+#endif
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+// 正面化模型: 137x136权重（行主序）及按GEMM微内核列面板打包的副本
+struct FrontalizationModel {
+    std::vector<float> weights;
+    std::vector<float> packed;
+};
+
+#ifdef ONNX_AVAILABLE
+// ONNX情绪模型会话；Session::Run可多线程并发调用，各分析器共享同一会话
+struct OnnxModel {
+    std::unique_ptr<Ort::Session> session;
+    std::string input_name;
+    std::string output_name;
+};
+#endif
+
+// 注册表统计
+struct ModelRegistryStats {
+    long long loads = 0;   // 实际从磁盘加载的次数
+    long long hits = 0;    // 复用已加载模型的次数
+    int live = 0;          // 当前仍被持有的模型数
+};
+
+// 进程级不可变模型注册表: 按（模型类型、规范路径、文件内容哈希）的FNV-1a哈希缓存已加载的模型，
+// 以shared_ptr<const T>分发给各分析器。注册表只保存weak_ptr，最后一个持有者释放后模型随之释放；
+// 文件在磁盘上被替换后下次请求重新加载。同一模型的并发请求只加载一次，不同模型可并行加载
+namespace ModelRegistry {
+    // 模型键: kind、规范路径与文件内容哈希的FNV-1a哈希（每次读取整个文件）；文件不存在时只哈希路径
+    uint64_t modelKey(const std::string& kind, const std::string& path);
+
+    // 文件内容的FNV-1a哈希（按64位字，读取整个文件），无法读取时返回false
+    bool contentHash(const std::string& path, uint64_t& hash);
+
+    // 返回kind/path对应的已加载模型，不存在时调用load加载并登记；load返回nullptr表示失败（不缓存）
+    std::shared_ptr<const void> acquireShared(const std::string& kind, const std::string& path,
+                                              const std::function<std::shared_ptr<const void>()>& load);
+
+    template <typename T>
+    std::shared_ptr<const T> acquire(const std::string& kind, const std::string& path,
+                                     const std::function<std::shared_ptr<const T>()>& load) {
+        return std::static_pointer_cast<const T>(acquireShared(kind, path, [&load]() {
+            return std::shared_ptr<const void>(load());
+        }));
+    }
+
+#ifdef DLIB_AVAILABLE
+    // dlib正面人脸检测器的权重，只反序列化一次；检测器有扫描状态，使用方各自复制一份
+    std::shared_ptr<const dlib::frontal_face_detector> frontalFaceDetector();
+#endif
+
+#ifdef ONNX_AVAILABLE
+    // 进程共享的ONNX Runtime环境（ORT建议每个进程只创建一个）；有意不析构，保证晚于所有会话释放
+    Ort::Env& ortEnv();
+#endif
+
+    ModelRegistryStats stats();
+}
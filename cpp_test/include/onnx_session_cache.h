@@ -0,0 +1,34 @@
+#pragma once
+
+#ifdef ONNX_AVAILABLE
+#include <onnxruntime_cxx_api.h>
+#endif
+
+#include <memory>
+#include <string>
+
+// ONNX会话配置: 图优化级别及优化后模型的磁盘缓存
+struct OnnxSessionConfig {
+    int optimization_level = 2;   // 0关闭, 1基本, 2扩展, 3全部（ORT_DISABLE_ALL..ORT_ENABLE_ALL）
+    bool cache = true;            // 缓存优化后的模型，之后的启动跳过图优化
+    std::string cache_dir;        // 缓存目录，空表示当前用户的缓存目录（见cachePath）
+};
+
+// 优化模型缓存: 首次加载时由ORT优化计算图并通过SetOptimizedModelFilePath写出，之后的进程直接加载
+// 优化后的模型并关闭图优化。缓存文件名由模型内容哈希、ORT版本和优化级别决定，模型或ORT升级后
+// 自动失效；先写临时文件再改名，多个进程同时启动时不会读到写了一半的文件。优化后的模型可能含
+// 本机执行提供程序专用的融合算子，缓存目录应只在同类主机间共享
+namespace OnnxSessionCache {
+    // 缓存文件路径；不缓存（关闭缓存、未开启优化、模型不可读或找不到用户缓存目录）时返回空字符串。
+    // 默认目录: Windows为 %LOCALAPPDATA%\emotion_ort_cache，其他系统为 $XDG_CACHE_HOME/emotion_ort_cache
+    // 或 ~/.cache/emotion_ort_cache。目录创建为仅所有者可访问；POSIX下属于其他用户或组/其他人可写的
+    // 目录和缓存文件不会被使用
+    std::string cachePath(const std::string& model_path, const OnnxSessionConfig& config);
+
+#ifdef ONNX_AVAILABLE
+    // 按配置创建会话: 有缓存时加载缓存（关闭图优化），否则优化原模型并写出缓存。
+    // cache_hit非空时写入是否使用了缓存；失败抛出Ort::Exception
+    std::unique_ptr<Ort::Session> createSession(const std::string& model_path, const OnnxSessionConfig& config,
+                                                bool* cache_hit = nullptr);
+#endif
+}
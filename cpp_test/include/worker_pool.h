@@ -0,0 +1,40 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// 常驻工作线程池: 线程在首次需要时创建并一直保留到池析构，避免每次调用都创建和回收线程。
+// run(count, fn) 在调用线程（index 0）和 count-1 个工作线程上并行执行 fn(index)，全部完成后返回；
+// 工作线程抛出的异常在调用线程重新抛出。同一个池不可被多个线程同时调用run
+class WorkerPool {
+public:
+    WorkerPool() = default;
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    void run(int count, const std::function<void(int)>& fn);
+
+    // 已创建的工作线程数（不含调用线程）
+    int size() const { return static_cast<int>(threads_.size()); }
+
+private:
+    void workerLoop(int index, uint64_t generation);
+
+    std::vector<std::thread> threads_;
+    std::mutex mutex_;
+    std::condition_variable start_;
+    std::condition_variable done_;
+    const std::function<void(int)>* job_ = nullptr;
+    int participants_ = 0;        // 本轮参与的线程数（含调用线程）
+    int remaining_ = 0;           // 本轮尚未完成的工作线程数
+    uint64_t generation_ = 0;     // 每次run加1，唤醒工作线程
+    std::exception_ptr error_;
+    bool stop_ = false;
+};
@@ -0,0 +1,1086 @@
+#include "benchmark.h"
+#include "landmark_kernels.h"
+#include "utils.h"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <random>
+#include <thread>
+
+#ifdef DLIB_AVAILABLE
+#include <dlib/opencv.h>
+#include <dlib/image_processing/shape_predictor.h>
+#endif
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+namespace {
+
+// 最近秩法求百分位，values须已排序
+double percentile(const std::vector<double>& values, double p) {
+    if (values.empty()) {
+        return 0.0;
+    }
+    size_t rank = static_cast<size_t>(std::ceil(p * values.size()));
+    rank = std::max<size_t>(rank, 1);
+    return values[std::min(rank, values.size()) - 1];
+}
+
+// 关键点预算的可读名称，与defaultLandmarkBudgets的命名一致
+std::string budgetName(const ErtBudget& budget) {
+    if (budget.full()) {
+        return "full cascade";
+    }
+    std::string name;
+    if (budget.cascades > 0) {
+        name = std::to_string(budget.cascades) + " cascades";
+    }
+    if (budget.trees > 0) {
+        name += (name.empty() ? "" : " x ") + std::to_string(budget.trees) + " trees";
+    }
+    return name;
+}
+
+#ifdef ONNX_AVAILABLE
+// 在会话上推理一批确定性的合成特征，返回全部输出
+std::vector<float> runSyntheticBatch(Ort::Session& session) {
+    auto shape = session.GetInputTypeInfo(0).GetTensorTypeAndShapeInfo().GetShape();
+    const int64_t dim = shape.size() >= 2 && shape.back() > 0 ? shape.back()
+                                                               : LandmarkKernels::featureCount(false);
+    const int64_t batch = 16;
+    std::vector<float> features(static_cast<size_t>(batch * dim));
+    for (size_t k = 0; k < features.size(); ++k) {
+        features[k] = std::sin(0.37f * static_cast<float>(k));
+    }
+    std::vector<int64_t> input_shape = {batch, dim};
+
+    Ort::AllocatorWithDefaultOptions allocator;
+    auto input_name = session.GetInputNameAllocated(0, allocator);
+    auto output_name = session.GetOutputNameAllocated(0, allocator);
+    const char* input_names[] = {input_name.get()};
+    const char* output_names[] = {output_name.get()};
+
+    auto memory_info = Ort::MemoryInfo::CreateCpu(OrtArenaAllocator, OrtMemTypeDefault);
+    Ort::Value input = Ort::Value::CreateTensor<float>(memory_info, features.data(), features.size(),
+                                                       input_shape.data(), input_shape.size());
+    auto outputs = session.Run(Ort::RunOptions{nullptr}, input_names, &input, 1, output_names, 1);
+    const float* data = outputs[0].GetTensorMutableData<float>();
+    return std::vector<float>(data, data + outputs[0].GetTensorTypeAndShapeInfo().GetElementCount());
+}
+#endif
+
+// 从扁平JSON中读取 "key": number
+bool readJsonNumber(const std::string& json, const std::string& key, double& value) {
+    size_t pos = json.find("\"" + key + "\"");
+    if (pos == std::string::npos) {
+        return false;
+    }
+    pos = json.find(':', pos);
+    if (pos == std::string::npos) {
+        return false;
+    }
+    try {
+        value = std::stod(json.substr(pos + 1));
+    } catch (const std::exception&) {
+        return false;
+    }
+    return true;
+}
+
+// 长边缩放到target像素
+cv::Mat resizeLongSide(const cv::Mat& image, int target) {
+    const int long_side = std::max(image.cols, image.rows);
+    const double scale = static_cast<double>(target) / long_side;
+    cv::Mat resized;
+    cv::resize(image, resized, cv::Size(), scale, scale,
+               scale < 1.0 ? cv::INTER_AREA : cv::INTER_LINEAR);
+    return resized;
+}
+
+} // namespace
+
+Benchmark::Benchmark(EmotionAnalyzer& analyzer, const BenchmarkConfig& config)
+    : analyzer_(analyzer), config_(config) {
+}
+
+bool Benchmark::buildCorpus() {
+    corpus_.clear();
+    sources_.clear();
+
+    std::vector<cv::String> files;
+    try {
+        cv::glob(config_.image_dir + "/*", files, false);
+    } catch (const cv::Exception& e) {
+        std::cerr << "无法读取图像目录: " << config_.image_dir << " (" << e.what() << ")" << std::endl;
+        return false;
+    }
+    std::sort(files.begin(), files.end());
+
+    for (const auto& file : files) {
+        cv::Mat image = cv::imread(file);
+        if (!image.empty()) {
+            sources_.push_back(image);
+        }
+    }
+
+    if (sources_.empty()) {
+        std::cerr << "图像目录中没有可用的图像: " << config_.image_dir << std::endl;
+        return false;
+    }
+
+    // Every source image at every configured resolution
+    for (const auto& image : sources_) {
+        for (int resolution : config_.resolutions) {
+            corpus_.push_back(resizeLongSide(image, resolution));
+        }
+    }
+
+    // Multi-face composites: slide a window over the sources so each composite differs
+    composite_begin_ = corpus_.size();
+    if (config_.composite_faces > 1) {
+        for (size_t start = 0; start < sources_.size(); ++start) {
+            std::vector<cv::Mat> faces;
+            for (int k = 0; k < config_.composite_faces; ++k) {
+                faces.push_back(sources_[(start + k) % sources_.size()]);
+            }
+            corpus_.push_back(makeComposite(faces));
+        }
+    }
+
+    std::cout << "基准语料: " << sources_.size() << " 张源图像, " << corpus_.size() << " 张测试图像" << std::endl;
+    return true;
+}
+
+cv::Mat Benchmark::makeComposite(const std::vector<cv::Mat>& faces) {
+    const int tile = config_.composite_tile;
+    const int cols = static_cast<int>(std::ceil(std::sqrt(static_cast<double>(faces.size()))));
+    const int rows = static_cast<int>((faces.size() + cols - 1) / cols);
+
+    cv::Mat canvas(rows * tile, cols * tile, CV_8UC3, cv::Scalar(0, 0, 0));
+    for (size_t i = 0; i < faces.size(); ++i) {
+        // Letterbox each face into its tile so the aspect ratio is preserved
+        cv::Mat scaled = resizeLongSide(faces[i], tile);
+        const int x = static_cast<int>(i % cols) * tile + (tile - scaled.cols) / 2;
+        const int y = static_cast<int>(i / cols) * tile + (tile - scaled.rows) / 2;
+        scaled.copyTo(canvas(cv::Rect(x, y, scaled.cols, scaled.rows)));
+    }
+
+    return canvas;
+}
+
+void Benchmark::analyzeCorpusImage(size_t index, AnalysisWorkspace& workspace, EmotionResult& result) {
+    const cv::Mat& image = corpus_[index];
+    if (index >= composite_begin_) {
+        // Every face of a composite, not just the first: detection, then one batched inference
+        std::vector<cv::Rect> rects;
+        for (const auto& face : analyzer_.detectFaces(image)) {
+            rects.push_back(face.rect);
+        }
+        analyzer_.analyzeFacesInRects(image, rects);
+        return;
+    }
+    // Unrelated images: never warm-start landmarks from the previous one
+    workspace.previous_landmarks.clear();
+    workspace.tracked_frames = 0;
+    analyzer_.analyzeEmotion(image, workspace, result);
+}
+
+BenchmarkResult Benchmark::run() {
+    BenchmarkResult result;
+    result.corpus_size = static_cast<int>(corpus_.size());
+    result.timestamp = Utils::getCurrentTimeString();
+
+    if (corpus_.empty()) {
+        return result;
+    }
+
+    // The stateless analyzeEmotion(image) logs every frame to the console; the workspace overload
+    // is quiet, so the timings measure the pipeline rather than terminal output
+    AnalysisWorkspace workspace;
+    EmotionResult emotion;
+    for (int i = 0; i < config_.warmup_iterations; ++i) {
+        for (size_t k = 0; k < corpus_.size(); ++k) {
+            analyzeCorpusImage(k, workspace, emotion);
+        }
+    }
+
+    std::vector<double> latencies;
+    latencies.reserve(corpus_.size() * config_.iterations);
+
+    auto total_start = std::chrono::steady_clock::now();
+    for (int i = 0; i < config_.iterations; ++i) {
+        for (size_t k = 0; k < corpus_.size(); ++k) {
+            auto start = std::chrono::steady_clock::now();
+            analyzeCorpusImage(k, workspace, emotion);
+            auto end = std::chrono::steady_clock::now();
+            latencies.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+        }
+    }
+    result.total_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - total_start).count();
+
+    std::sort(latencies.begin(), latencies.end());
+    result.measured_images = static_cast<int>(latencies.size());
+    result.images_per_second = result.total_seconds > 0 ? latencies.size() / result.total_seconds : 0.0;
+    double sum = 0.0;
+    for (double latency : latencies) {
+        sum += latency;
+    }
+    result.mean_ms = sum / latencies.size();
+    result.p50_ms = percentile(latencies, 0.50);
+    result.p99_ms = percentile(latencies, 0.99);
+    result.peak_rss_mb = peakResidentMemoryMB();
+
+    return result;
+}
+
+std::vector<DetectorSweepEntry> Benchmark::defaultDetectorSweep() {
+    std::vector<DetectorSweepEntry> entries(13);
+    entries[0].name = "upsample x1 (reference)";
+    entries[0].config.upsample = 1;
+    entries[1].name = "dlib default";
+    entries[2].name = "min face 120px";
+    entries[2].config.min_face_size = 120;
+    entries[3].name = "min face 160px";
+    entries[3].config.min_face_size = 160;
+    entries[4].name = "pyramid ratio 0.7";
+    entries[4].config.pyramid_ratio = 0.7;
+    entries[5].name = "ratio 0.7 + min 120px";
+    entries[5].config.pyramid_ratio = 0.7;
+    entries[5].config.min_face_size = 120;
+    entries[6].name = "threshold +0.3";
+    entries[6].config.threshold = 0.3;
+    entries[7].name = "ladder 160/80/40";
+    entries[7].config.ladder = true;
+    entries[8].name = "haar cascade";
+    entries[8].config.backend = DetectorBackend::Cascade;
+    entries[8].config.cascade_path = kHaarCascadeFile;
+    entries[9].name = "lbp cascade";
+    entries[9].config.backend = DetectorBackend::Cascade;
+    entries[9].config.cascade_path = kLbpCascadeFile;
+    // Everything above compares configurations on one thread; the last two rows show the
+    // multi-threaded HOG scan (levels and row strips spread over all cores)
+    for (auto& entry : entries) {
+        entry.config.threads = 1;
+    }
+    entries[10].name = "dlib default, all cores";
+    entries[10].config.threads = 0;
+    entries[11].name = "upsample x1, all cores";
+    entries[11].config.upsample = 1;
+    entries[11].config.threads = 0;
+    entries[12].name = "tiles 512/128, all cores";
+    entries[12].config.threads = 0;
+    entries[12].config.tile_size = 512;
+    entries[12].config.tile_overlap = 128;
+    return entries;
+}
+
+std::vector<DetectorSweepEntry> Benchmark::runDetectorSweep(const std::vector<DetectorSweepEntry>& configs) {
+    std::vector<DetectorSweepEntry> entries = configs;
+    if (entries.empty() || sources_.empty()) {
+        return entries;
+    }
+
+    const DetectorConfig saved = analyzer_.getDetectorConfig();
+    std::vector<std::vector<DetectedFace>> reference;
+
+    for (size_t c = 0; c < entries.size(); ++c) {
+        DetectorSweepEntry& entry = entries[c];
+        analyzer_.setDetectorConfig(entry.config);
+
+        // Untimed pass also records what this configuration finds
+        std::vector<std::vector<DetectedFace>> found;
+        for (const auto& image : sources_) {
+            found.push_back(analyzer_.detectFaces(image));
+        }
+        // A backend that fails to load leaves the previous detector in place
+        entry.detector = analyzer_.getDetectorName();
+
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < config_.iterations; ++i) {
+            for (const auto& image : sources_) {
+                analyzer_.detectFaces(image);
+            }
+        }
+        const double total_ms = std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - start).count();
+        entry.ms_per_image = total_ms / (std::max(1, config_.iterations) * sources_.size());
+
+        if (c == 0) {
+            reference = found;
+        }
+
+        int reference_faces = 0;
+        entry.faces_found = 0;
+        entry.faces_matched = 0;
+        for (size_t i = 0; i < sources_.size(); ++i) {
+            entry.faces_found += static_cast<int>(found[i].size());
+            reference_faces += static_cast<int>(reference[i].size());
+            for (const auto& expected : reference[i]) {
+                for (const auto& face : found[i]) {
+                    if (FaceDetection::intersectionOverUnion(expected.rect, face.rect) >= 0.5) {
+                        ++entry.faces_matched;
+                        break;
+                    }
+                }
+            }
+        }
+        entry.recall = reference_faces > 0 ? static_cast<double>(entry.faces_matched) / reference_faces : 0.0;
+    }
+
+    analyzer_.setDetectorConfig(saved);
+    return entries;
+}
+
+void Benchmark::printDetectorSweep(const std::vector<DetectorSweepEntry>& entries) {
+    std::cout << "========== 检测器配置: 速度 vs 召回率 ==========" << std::endl;
+    std::cout << std::left << std::setw(26) << "配置" << std::setw(16) << "后端"
+              << std::right << std::setw(12) << "ms/图像" << std::setw(10) << "人脸数"
+              << std::setw(10) << "召回率" << std::endl;
+    for (const auto& entry : entries) {
+        std::cout << std::left << std::setw(26) << entry.name << std::setw(16) << entry.detector
+                  << std::right << std::fixed << std::setprecision(2)
+                  << std::setw(12) << entry.ms_per_image << std::setw(10) << entry.faces_found
+                  << std::setw(9) << entry.recall * 100.0 << "%" << std::endl;
+    }
+    std::cout << "召回率以第一项配置的检测结果为参考（交并比 >= 0.5）" << std::endl;
+    std::cout << "==============================================" << std::endl;
+}
+
+LandmarkComparison Benchmark::compareShapePredictors(const std::string& shape_predictor_path) {
+    LandmarkComparison comparison;
+
+#ifdef DLIB_AVAILABLE
+    dlib::shape_predictor reference;
+    ErtShapePredictor native;
+    try {
+        dlib::deserialize(shape_predictor_path) >> reference;
+    } catch (const std::exception& e) {
+        std::cerr << "无法加载关键点模型: " << e.what() << std::endl;
+        return comparison;
+    }
+    if (!native.load(shape_predictor_path)) {
+        return comparison;
+    }
+
+    // Faces from the analyzer's detector, on the same grayscale both predictors see
+    std::vector<cv::Mat> grays;
+    std::vector<std::vector<cv::Rect>> faces;
+    for (const auto& image : sources_) {
+        cv::Mat gray;
+        if (!EmotionAnalyzer::toGray(image, gray)) {
+            continue;
+        }
+        std::vector<cv::Rect> rects;
+        for (const auto& face : analyzer_.detectFaces(gray)) {
+            rects.push_back(face.rect);
+            ++comparison.faces;
+        }
+        grays.push_back(gray);
+        faces.push_back(rects);
+    }
+    if (comparison.faces == 0) {
+        std::cerr << "源图像中未检测到人脸" << std::endl;
+        return comparison;
+    }
+
+    std::vector<cv::Point2f> landmarks;
+    std::vector<std::vector<cv::Point2f>> reference_landmarks;
+    std::vector<std::vector<cv::Point2f>> native_landmarks;
+    const int iterations = std::max(1, config_.iterations);
+
+    auto start = std::chrono::steady_clock::now();
+    for (int it = 0; it < iterations; ++it) {
+        for (size_t i = 0; i < grays.size(); ++i) {
+            dlib::cv_image<unsigned char> dlib_image(grays[i]);
+            for (const auto& rect : faces[i]) {
+                dlib::full_object_detection shape = reference(dlib_image, FaceDetection::toDlibRect(rect));
+                if (it == 0) {
+                    landmarks.clear();
+                    for (unsigned long k = 0; k < shape.num_parts(); ++k) {
+                        landmarks.emplace_back(static_cast<float>(shape.part(k).x()),
+                                               static_cast<float>(shape.part(k).y()));
+                    }
+                    reference_landmarks.push_back(landmarks);
+                }
+            }
+        }
+    }
+    comparison.dlib_ms_per_face = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start).count() / (iterations * comparison.faces);
+
+    start = std::chrono::steady_clock::now();
+    for (int it = 0; it < iterations; ++it) {
+        for (size_t i = 0; i < grays.size(); ++i) {
+            for (const auto& rect : faces[i]) {
+                native.predict(grays[i], rect, landmarks);
+                if (it == 0) {
+                    native_landmarks.push_back(landmarks);
+                }
+            }
+        }
+    }
+    comparison.native_ms_per_face = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start).count() / (iterations * comparison.faces);
+
+    double total_error = 0.0;
+    int points = 0;
+    int identical = 0;
+    for (size_t f = 0; f < reference_landmarks.size(); ++f) {
+        const size_t n = std::min(reference_landmarks[f].size(), native_landmarks[f].size());
+        for (size_t k = 0; k < n; ++k) {
+            const cv::Point2f d = reference_landmarks[f][k] - native_landmarks[f][k];
+            const double error = std::sqrt(d.x * d.x + d.y * d.y);
+            total_error += error;
+            comparison.max_error_px = std::max(comparison.max_error_px, error);
+            identical += (error == 0.0) ? 1 : 0;
+            ++points;
+        }
+    }
+    comparison.mean_error_px = points > 0 ? total_error / points : 0.0;
+    comparison.identical_ratio = points > 0 ? static_cast<double>(identical) / points : 0.0;
+#else
+    std::cerr << "dlib不可用，无法对比关键点回归器: " << shape_predictor_path << std::endl;
+#endif
+
+    return comparison;
+}
+
+void Benchmark::printLandmarkComparison(const LandmarkComparison& comparison) {
+    std::cout << "========== 关键点回归: dlib vs 内置ERT求值器 ==========" << std::endl;
+    std::cout << std::fixed << std::setprecision(3);
+    std::cout << "人脸数:           " << comparison.faces << std::endl;
+    std::cout << "dlib:             " << comparison.dlib_ms_per_face << " ms/人脸" << std::endl;
+    std::cout << "内置求值器:       " << comparison.native_ms_per_face << " ms/人脸" << std::endl;
+    if (comparison.native_ms_per_face > 0.0) {
+        std::cout << "加速比:           " << std::setprecision(2)
+                  << comparison.dlib_ms_per_face / comparison.native_ms_per_face << "x" << std::endl;
+    }
+    std::cout << std::setprecision(3);
+    std::cout << "平均误差:         " << comparison.mean_error_px << " px" << std::endl;
+    std::cout << "最大误差:         " << comparison.max_error_px << " px" << std::endl;
+    std::cout << "坐标完全一致:     " << std::setprecision(1) << comparison.identical_ratio * 100.0 << "%" << std::endl;
+    std::cout << "=====================================================" << std::endl;
+}
+
+std::vector<LandmarkBudgetEntry> Benchmark::defaultLandmarkBudgets() {
+    std::vector<LandmarkBudgetEntry> entries(7);
+    entries[0].name = "full cascade";
+    entries[1].name = "8 cascades";
+    entries[1].budget.cascades = 8;
+    entries[2].name = "6 cascades";
+    entries[2].budget.cascades = 6;
+    entries[3].name = "4 cascades";
+    entries[3].budget.cascades = 4;
+    entries[4].name = "2 cascades";
+    entries[4].budget.cascades = 2;
+    entries[5].name = "250 trees/cascade";
+    entries[5].budget.trees = 250;
+    entries[6].name = "6 cascades x 250 trees";
+    entries[6].budget.cascades = 6;
+    entries[6].budget.trees = 250;
+    return entries;
+}
+
+std::vector<LandmarkBudgetEntry> Benchmark::runLandmarkBudgetReport(const std::vector<LandmarkBudgetEntry>& budgets) {
+    std::vector<LandmarkBudgetEntry> entries = budgets;
+    if (entries.empty() || sources_.empty()) {
+        return entries;
+    }
+
+    const ErtBudget saved = analyzer_.getLandmarkBudget();
+
+    // Faces are detected once, every budget regresses the same boxes
+    std::vector<std::vector<cv::Rect>> rects;
+    for (const auto& image : sources_) {
+        std::vector<cv::Rect> boxes;
+        for (const auto& face : analyzer_.detectFaces(image)) {
+            boxes.push_back(face.rect);
+        }
+        rects.push_back(boxes);
+    }
+
+    analyzer_.setLandmarkBudget(ErtBudget());
+    std::vector<std::vector<FaceEmotion>> reference;
+    for (size_t i = 0; i < sources_.size(); ++i) {
+        reference.push_back(analyzer_.analyzeFacesInRects(sources_[i], rects[i]));
+    }
+
+    for (auto& entry : entries) {
+        analyzer_.setLandmarkBudget(entry.budget);
+
+        std::vector<std::vector<FaceEmotion>> found;
+        for (size_t i = 0; i < sources_.size(); ++i) {
+            found.push_back(analyzer_.analyzeFacesInRects(sources_[i], rects[i]));
+        }
+
+        int total_faces = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (int it = 0; it < config_.iterations; ++it) {
+            for (size_t i = 0; i < sources_.size(); ++i) {
+                analyzer_.analyzeFacesInRects(sources_[i], rects[i]);
+                total_faces += static_cast<int>(rects[i].size());
+            }
+        }
+        const double total_ms = std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - start).count();
+        entry.ms_per_face = total_faces > 0 ? total_ms / total_faces : 0.0;
+
+        double squared_px = 0.0, squared_iod = 0.0, arousal_error = 0.0, valence_error = 0.0;
+        int points = 0;
+        entry.faces = 0;
+        entry.max_av_deviation = 0.0;
+        for (size_t i = 0; i < sources_.size(); ++i) {
+            for (size_t f = 0; f < rects[i].size(); ++f) {
+                const FaceEmotion& expected = reference[i][f];
+                const FaceEmotion& actual = found[i][f];
+                if (!expected.success || !actual.success ||
+                    expected.landmarks.size() != actual.landmarks.size()) {
+                    continue;
+                }
+
+                // Outer eye corners of the 68-point layout
+                double iod = 0.0;
+                if (expected.landmarks.size() == 68) {
+                    const cv::Point2f eyes = expected.landmarks[45] - expected.landmarks[36];
+                    iod = std::sqrt(eyes.x * eyes.x + eyes.y * eyes.y);
+                }
+                for (size_t k = 0; k < expected.landmarks.size(); ++k) {
+                    const cv::Point2f d = actual.landmarks[k] - expected.landmarks[k];
+                    const double squared = d.x * d.x + d.y * d.y;
+                    squared_px += squared;
+                    squared_iod += iod > 0.0 ? squared / (iod * iod) : 0.0;
+                    ++points;
+                }
+
+                const double da = std::abs(actual.emotion.arousal - expected.emotion.arousal);
+                const double dv = std::abs(actual.emotion.valence - expected.emotion.valence);
+                arousal_error += da;
+                valence_error += dv;
+                entry.max_av_deviation = std::max(entry.max_av_deviation, std::max(da, dv));
+                ++entry.faces;
+            }
+        }
+        entry.rmse_px = points > 0 ? std::sqrt(squared_px / points) : 0.0;
+        entry.rmse_iod = points > 0 ? std::sqrt(squared_iod / points) : 0.0;
+        entry.arousal_mae = entry.faces > 0 ? arousal_error / entry.faces : 0.0;
+        entry.valence_mae = entry.faces > 0 ? valence_error / entry.faces : 0.0;
+    }
+
+    analyzer_.setLandmarkBudget(saved);
+    return entries;
+}
+
+void Benchmark::printLandmarkBudgetReport(const std::vector<LandmarkBudgetEntry>& entries) {
+    std::cout << "========== 关键点级联截断: 速度 vs 精度 ==========" << std::endl;
+    std::cout << std::left << std::setw(26) << "预算"
+              << std::right << std::setw(12) << "ms/人脸" << std::setw(8) << "人脸数"
+              << std::setw(12) << "RMSE(px)" << std::setw(12) << "RMSE(%IOD)"
+              << std::setw(12) << "arousal偏差" << std::setw(12) << "valence偏差"
+              << std::setw(12) << "最大偏差" << std::endl;
+    for (const auto& entry : entries) {
+        std::cout << std::left << std::setw(26) << entry.name
+                  << std::right << std::fixed << std::setprecision(3)
+                  << std::setw(12) << entry.ms_per_face << std::setw(8) << entry.faces
+                  << std::setw(12) << entry.rmse_px << std::setw(12) << entry.rmse_iod * 100.0
+                  << std::setprecision(4)
+                  << std::setw(12) << entry.arousal_mae << std::setw(12) << entry.valence_mae
+                  << std::setw(12) << entry.max_av_deviation << std::endl;
+    }
+    std::cout << "偏差均相对完整级联的结果；IOD为外眼角（36、45号点）间距；耗时含批量推理" << std::endl;
+    std::cout << "=================================================" << std::endl;
+}
+
+TrackingReport Benchmark::runTrackingReport(int frames_per_source) {
+    TrackingReport report;
+    report.budget = analyzer_.getLandmarkBudget();
+    const LandmarkTracking saved = analyzer_.getLandmarkTracking();
+
+    struct FrameResult {
+        bool found = false;
+        std::vector<cv::Point2f> landmarks;
+        EmotionResult emotion;
+        double landmark_ms = 0.0;
+        int first_cascade = 0;
+    };
+
+    double full_ms = 0.0, tracked_ms = 0.0, squared = 0.0;
+    long long first_cascade_sum = 0;
+    int points = 0;
+
+    for (const auto& image : sources_) {
+        // A camera panning slowly over the source: a fixed-size window moving one pixel per frame
+        const int margin = std::min(frames_per_source, std::min(image.cols, image.rows) / 8);
+        if (margin < 2) {
+            continue;
+        }
+        const cv::Size window(image.cols - margin, image.rows - margin);
+
+        std::vector<FrameResult> runs[2];
+        for (int mode = 0; mode < 2; ++mode) {
+            LandmarkTracking tracking = saved;
+            tracking.enabled = (mode == 1);
+            analyzer_.setLandmarkTracking(tracking);
+
+            AnalysisWorkspace workspace;
+            runs[mode].resize(margin);
+            for (int t = 0; t < margin; ++t) {
+                FrameResult& frame = runs[mode][t];
+                frame.found = analyzer_.analyzeEmotion(image(cv::Rect(t, t / 2, window.width, window.height)),
+                                                       workspace, frame.emotion);
+                frame.landmarks = workspace.raw_landmarks;
+                frame.landmark_ms = workspace.landmark_ms;
+                frame.first_cascade = workspace.first_cascade;
+            }
+        }
+
+        for (int t = 0; t < margin; ++t) {
+            const FrameResult& full = runs[0][t];
+            const FrameResult& tracked = runs[1][t];
+            if (!full.found || !tracked.found || full.landmarks.size() != tracked.landmarks.size()) {
+                continue;
+            }
+            ++report.frames;
+            full_ms += full.landmark_ms;
+            tracked_ms += tracked.landmark_ms;
+            first_cascade_sum += tracked.first_cascade;
+            report.full_runs += tracked.first_cascade == 0 ? 1 : 0;
+            for (size_t k = 0; k < full.landmarks.size(); ++k) {
+                const cv::Point2f d = tracked.landmarks[k] - full.landmarks[k];
+                squared += d.x * d.x + d.y * d.y;
+                ++points;
+            }
+            report.max_av_deviation = std::max(report.max_av_deviation, static_cast<double>(std::max(
+                std::abs(tracked.emotion.arousal - full.emotion.arousal),
+                std::abs(tracked.emotion.valence - full.emotion.valence))));
+        }
+    }
+
+    if (report.frames > 0) {
+        report.full_landmark_ms = full_ms / report.frames;
+        report.tracked_landmark_ms = tracked_ms / report.frames;
+        report.mean_first_cascade = static_cast<double>(first_cascade_sum) / report.frames;
+    }
+    report.rmse_px = points > 0 ? std::sqrt(squared / points) : 0.0;
+
+    analyzer_.setLandmarkTracking(saved);
+    return report;
+}
+
+void Benchmark::printTrackingReport(const TrackingReport& report) {
+    std::cout << "========== 视频关键点跟踪: 完整回归 vs 热启动 ==========" << std::endl;
+    std::cout << "关键点预算:       " << budgetName(report.budget) << std::endl;
+    std::cout << std::fixed << std::setprecision(3);
+    std::cout << "帧数:             " << report.frames << "（其中完整回归 " << report.full_runs << " 帧）" << std::endl;
+    std::cout << "完整回归:         " << report.full_landmark_ms << " ms/帧" << std::endl;
+    std::cout << "热启动:           " << report.tracked_landmark_ms << " ms/帧" << std::endl;
+    if (report.tracked_landmark_ms > 0.0) {
+        std::cout << "加速比:           " << std::setprecision(2)
+                  << report.full_landmark_ms / report.tracked_landmark_ms << "x" << std::endl;
+    }
+    std::cout << std::setprecision(2);
+    std::cout << "平均起始级联:     " << report.mean_first_cascade << std::endl;
+    std::cout << std::setprecision(3);
+    std::cout << "关键点RMSE:       " << report.rmse_px << " px" << std::endl;
+    std::cout << "最大AV偏差:       " << std::setprecision(4) << report.max_av_deviation << std::endl;
+    std::cout << "耗时仅含关键点回归；偏差相对逐帧完整回归的结果" << std::endl;
+    std::cout << "=======================================================" << std::endl;
+}
+
+SharedModelReport Benchmark::runSharedModelReport(const std::string& onnx_model_path,
+                                                  const std::string& frontalization_model_path,
+                                                  const std::string& shape_predictor_path,
+                                                  const DetectorConfig& detector_config, int count) {
+    SharedModelReport report;
+    report.rss_before_mb = peakResidentMemoryMB();
+
+    std::vector<std::unique_ptr<EmotionAnalyzer>> analyzers;
+    double rest_ms = 0.0;
+    for (int i = 0; i < count; ++i) {
+        const auto start = std::chrono::high_resolution_clock::now();
+        auto analyzer = std::make_unique<EmotionAnalyzer>(onnx_model_path, frontalization_model_path,
+                                                          shape_predictor_path);
+        analyzer->setDetectorConfig(detector_config);
+        if (!analyzer->initialize()) {
+            std::cerr << "分析器 " << i << " 初始化失败" << std::endl;
+            break;
+        }
+        const double ms = std::chrono::duration<double, std::milli>(
+            std::chrono::high_resolution_clock::now() - start).count();
+
+        if (i == 0) {
+            report.first_init_ms = ms;
+            report.rss_after_first_mb = peakResidentMemoryMB();
+        } else {
+            rest_ms += ms;
+        }
+        analyzers.push_back(std::move(analyzer));
+    }
+
+    report.analyzers = static_cast<int>(analyzers.size());
+    report.next_init_ms = report.analyzers > 1 ? rest_ms / (report.analyzers - 1) : 0.0;
+    report.rss_after_all_mb = peakResidentMemoryMB();
+    report.registry = ModelRegistry::stats();
+    return report;
+}
+
+void Benchmark::printSharedModelReport(const SharedModelReport& report) {
+    std::cout << "========== 共享模型: 多个分析器 ==========" << std::endl;
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "分析器数:           " << report.analyzers << std::endl;
+    std::cout << "首个初始化:         " << report.first_init_ms << " ms" << std::endl;
+    std::cout << "后续初始化:         " << std::setprecision(3) << report.next_init_ms << " ms/个" << std::endl;
+    std::cout << std::setprecision(1);
+    std::cout << "峰值RSS:            创建前 " << report.rss_before_mb << " MB, 首个后 "
+              << report.rss_after_first_mb << " MB, 全部后 " << report.rss_after_all_mb << " MB" << std::endl;
+    if (report.analyzers > 1) {
+        std::cout << "每个后续分析器:     " << std::setprecision(3)
+                  << (report.rss_after_all_mb - report.rss_after_first_mb) * 1024.0 / (report.analyzers - 1)
+                  << " KB" << std::endl;
+    }
+    std::cout << "注册表:             加载 " << report.registry.loads << " 次, 复用 " << report.registry.hits
+              << " 次, 存活模型 " << report.registry.live << std::endl;
+    std::cout << "==========================================" << std::endl;
+}
+
+HotReloadReport Benchmark::runHotReloadReport(const std::string& onnx_model_path, int reload_interval_ms) {
+    namespace fs = std::filesystem;
+    HotReloadReport report;
+    if (corpus_.empty()) {
+        return report;
+    }
+
+    // Two copies with different paths, so every reload really loads a new session; the suffix
+    // keeps concurrent report runs from overwriting each other's copies
+    std::error_code ec;
+    const std::string prefix = "hot_reload_" + std::to_string(std::random_device{}()) + "_";
+    const fs::path copies[2] = {fs::temp_directory_path(ec) / (prefix + "a.onnx"),
+                                fs::temp_directory_path(ec) / (prefix + "b.onnx")};
+    for (const auto& copy : copies) {
+        if (!fs::copy_file(onnx_model_path, copy, fs::copy_options::overwrite_existing, ec)) {
+            std::cerr << "无法复制模型到 " << copy.string() << ": " << ec.message() << std::endl;
+            return report;
+        }
+    }
+
+    AnalysisWorkspace workspace;
+    std::vector<EmotionResult> baseline(corpus_.size());
+    std::vector<char> baseline_found(corpus_.size());
+    for (size_t i = 0; i < corpus_.size(); ++i) {
+        baseline_found[i] = analyzer_.analyzeEmotion(corpus_[i], workspace, baseline[i]);
+    }
+
+    auto pass = [&](std::vector<double>& latencies, bool compare) {
+        EmotionResult result;
+        for (int round = 0; round < config_.iterations; ++round) {
+            for (size_t i = 0; i < corpus_.size(); ++i) {
+                auto start = std::chrono::steady_clock::now();
+                const bool found = analyzer_.analyzeEmotion(corpus_[i], workspace, result);
+                latencies.push_back(std::chrono::duration<double, std::milli>(
+                    std::chrono::steady_clock::now() - start).count());
+                if (!compare || !baseline_found[i]) {
+                    continue;
+                }
+                if (!found) {
+                    ++report.failed_requests;
+                } else if (result.arousal != baseline[i].arousal || result.valence != baseline[i].valence) {
+                    ++report.mismatches;
+                }
+            }
+        }
+    };
+
+    std::vector<double> steady;
+    pass(steady, false);
+
+    // Reloads run on their own thread while this one keeps analyzing
+    std::atomic<bool> stop{false};
+    double reload_ms = 0.0;
+    std::thread reloader([&]() {
+        for (int k = 0; !stop.load(); ++k) {
+            auto start = std::chrono::steady_clock::now();
+            if (analyzer_.reloadModels(copies[k % 2].string())) {
+                reload_ms += std::chrono::duration<double, std::milli>(
+                    std::chrono::steady_clock::now() - start).count();
+                ++report.reloads;
+            } else {
+                ++report.failed_reloads;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(reload_interval_ms));
+        }
+    });
+
+    std::vector<double> reloading;
+    pass(reloading, true);
+    stop = true;
+    reloader.join();
+
+    report.generation = analyzer_.modelGeneration();
+    report.requests = static_cast<int>(reloading.size());
+    report.mean_reload_ms = report.reloads > 0 ? reload_ms / report.reloads : 0.0;
+    std::sort(steady.begin(), steady.end());
+    std::sort(reloading.begin(), reloading.end());
+    report.steady_p50_ms = percentile(steady, 0.50);
+    report.steady_p99_ms = percentile(steady, 0.99);
+    report.steady_max_ms = steady.back();
+    report.reload_p50_ms = percentile(reloading, 0.50);
+    report.reload_p99_ms = percentile(reloading, 0.99);
+    report.reload_max_ms = reloading.back();
+
+    // Back to the original file; the copies are released with the last snapshot that used them
+    analyzer_.reloadModels(onnx_model_path);
+    for (const auto& copy : copies) {
+        fs::remove(copy, ec);
+    }
+    return report;
+}
+
+void Benchmark::printHotReloadReport(const HotReloadReport& report) {
+    std::cout << "========== 模型热重载: 分析中替换ONNX模型 ==========" << std::endl;
+    std::cout << std::fixed << std::setprecision(3);
+    std::cout << "请求数:           " << report.requests << std::endl;
+    std::cout << "无重载:           p50 " << report.steady_p50_ms << " ms, p99 " << report.steady_p99_ms
+              << " ms, 最大 " << report.steady_max_ms << " ms" << std::endl;
+    std::cout << "重载期间:         p50 " << report.reload_p50_ms << " ms, p99 " << report.reload_p99_ms
+              << " ms, 最大 " << report.reload_max_ms << " ms" << std::endl;
+    std::cout << std::setprecision(2);
+    std::cout << "重载:             " << report.reloads << " 次（失败 " << report.failed_reloads
+              << " 次）, 平均 " << report.mean_reload_ms << " ms/次, 模型代数 " << report.generation << std::endl;
+    std::cout << "失败请求:         " << report.failed_requests << std::endl;
+    std::cout << "结果不一致:       " << report.mismatches << std::endl;
+    std::cout << "重载在后台线程完成（加载+预热），分析线程只在下一个请求切换到新快照" << std::endl;
+    std::cout << "====================================================" << std::endl;
+}
+
+OnnxCacheReport Benchmark::runOnnxCacheReport(const std::string& onnx_model_path, const OnnxSessionConfig& config,
+                                              int runs) {
+    OnnxCacheReport report;
+    report.runs = std::max(1, runs);
+#ifdef ONNX_AVAILABLE
+    OnnxSessionConfig cached = config;
+    cached.cache = true;
+    OnnxSessionConfig uncached = config;
+    uncached.cache = false;
+    OnnxSessionConfig unoptimized = config;
+    unoptimized.optimization_level = 0;
+
+    report.cache_file = OnnxSessionCache::cachePath(onnx_model_path, cached);
+    if (report.cache_file.empty()) {
+        std::cerr << "优化级别为0或无法读取模型，没有可缓存的优化模型" << std::endl;
+        return report;
+    }
+    // Start cold, as the first worker on a fresh host would
+    std::error_code ec;
+    std::filesystem::remove(report.cache_file, ec);
+
+    auto timed = [&](const OnnxSessionConfig& session_config, double& total_ms, bool* cache_hit) {
+        auto start = std::chrono::steady_clock::now();
+        auto session = OnnxSessionCache::createSession(onnx_model_path, session_config, cache_hit);
+        total_ms += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        return session;
+    };
+
+    try {
+        bool hit = false;
+        timed(cached, report.first_ms, &hit);
+        if (hit) {
+            std::cerr << "缓存文件未能删除: " << report.cache_file << std::endl;
+            return report;
+        }
+
+        std::unique_ptr<Ort::Session> reference, from_cache;
+        report.cache_hit = true;
+        for (int i = 0; i < report.runs; ++i) {
+            reference = timed(unoptimized, report.unoptimized_ms, nullptr);
+            timed(uncached, report.optimized_ms, nullptr);
+            from_cache = timed(cached, report.cached_ms, &hit);
+            report.cache_hit = report.cache_hit && hit;
+        }
+        report.unoptimized_ms /= report.runs;
+        report.optimized_ms /= report.runs;
+        report.cached_ms /= report.runs;
+
+        const std::vector<float> expected = runSyntheticBatch(*reference);
+        const std::vector<float> actual = runSyntheticBatch(*from_cache);
+        if (expected.size() != actual.size()) {
+            std::cerr << "缓存模型的输出大小不同: " << actual.size() << " vs " << expected.size() << std::endl;
+            return report;
+        }
+        for (size_t k = 0; k < expected.size(); ++k) {
+            report.max_output_diff = std::max(report.max_output_diff,
+                                              static_cast<double>(std::abs(actual[k] - expected[k])));
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "ONNX会话创建失败: " << e.what() << std::endl;
+        return report;
+    }
+    report.available = true;
+#else
+    std::cerr << "ONNX Runtime不可用" << std::endl;
+#endif
+    return report;
+}
+
+void Benchmark::printOnnxCacheReport(const OnnxCacheReport& report) {
+    std::cout << "========== ONNX优化模型缓存: 会话创建耗时 ==========" << std::endl;
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "缓存文件:         " << report.cache_file << std::endl;
+    std::cout << "不优化:           " << report.unoptimized_ms << " ms" << std::endl;
+    std::cout << "每次优化:         " << report.optimized_ms << " ms" << std::endl;
+    std::cout << "首次（优化+写出）:" << report.first_ms << " ms" << std::endl;
+    std::cout << "加载缓存:         " << report.cached_ms << " ms" << (report.cache_hit ? "" : "（未全部命中）") << std::endl;
+    if (report.cached_ms > 0.0) {
+        std::cout << "相对每次优化:     " << report.optimized_ms / report.cached_ms << "x" << std::endl;
+    }
+    std::cout << "最大输出差异:     " << std::scientific << std::setprecision(2) << report.max_output_diff
+              << std::fixed << "（缓存模型 vs 未优化模型）" << std::endl;
+    std::cout << "耗时为" << report.runs << "次的平均值，首次启动只测一次" << std::endl;
+    std::cout << "====================================================" << std::endl;
+}
+
+bool Benchmark::saveBaseline(const BenchmarkResult& result, const std::string& path) {
+    std::ofstream file(path);
+    if (!file.is_open()) {
+        std::cerr << "无法创建基线文件: " << path << std::endl;
+        return false;
+    }
+
+    file << std::fixed << std::setprecision(4);
+    file << "{\n";
+    file << "  \"timestamp\": \"" << result.timestamp << "\",\n";
+    file << "  \"corpus_size\": " << result.corpus_size << ",\n";
+    file << "  \"measured_images\": " << result.measured_images << ",\n";
+    file << "  \"total_seconds\": " << result.total_seconds << ",\n";
+    file << "  \"images_per_second\": " << result.images_per_second << ",\n";
+    file << "  \"mean_ms\": " << result.mean_ms << ",\n";
+    file << "  \"p50_ms\": " << result.p50_ms << ",\n";
+    file << "  \"p99_ms\": " << result.p99_ms << ",\n";
+    file << "  \"peak_rss_mb\": " << result.peak_rss_mb << "\n";
+    file << "}\n";
+
+    return true;
+}
+
+bool Benchmark::loadBaseline(const std::string& path, BenchmarkResult& result) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        std::cerr << "无法打开基线文件: " << path << std::endl;
+        return false;
+    }
+
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    const std::string json = buffer.str();
+
+    double corpus_size = 0.0, measured_images = 0.0;
+    bool ok = readJsonNumber(json, "corpus_size", corpus_size) &&
+              readJsonNumber(json, "measured_images", measured_images) &&
+              readJsonNumber(json, "total_seconds", result.total_seconds) &&
+              readJsonNumber(json, "images_per_second", result.images_per_second) &&
+              readJsonNumber(json, "mean_ms", result.mean_ms) &&
+              readJsonNumber(json, "p50_ms", result.p50_ms) &&
+              readJsonNumber(json, "p99_ms", result.p99_ms) &&
+              readJsonNumber(json, "peak_rss_mb", result.peak_rss_mb);
+
+    if (!ok) {
+        std::cerr << "基线文件格式无效: " << path << std::endl;
+        return false;
+    }
+
+    result.corpus_size = static_cast<int>(corpus_size);
+    result.measured_images = static_cast<int>(measured_images);
+
+    size_t pos = json.find("\"timestamp\"");
+    if (pos != std::string::npos) {
+        size_t begin = json.find('"', json.find(':', pos));
+        size_t end = json.find('"', begin + 1);
+        if (begin != std::string::npos && end != std::string::npos) {
+            result.timestamp = json.substr(begin + 1, end - begin - 1);
+        }
+    }
+
+    return true;
+}
+
+bool Benchmark::compareWithBaseline(const BenchmarkResult& current, const BenchmarkResult& baseline,
+                                    double threshold, std::string& report) {
+    std::stringstream ss;
+    bool passed = true;
+
+    // change > 0 always means "worse"
+    auto check = [&](const char* name, double now, double before, bool higher_is_better) {
+        double change = 0.0;
+        if (before > 0.0) {
+            change = higher_is_better ? (before - now) / before : (now - before) / before;
+        }
+        const bool regressed = change > threshold;
+        passed = passed && !regressed;
+        ss << std::left << std::setw(20) << name
+           << std::right << std::fixed << std::setprecision(2)
+           << std::setw(12) << before << std::setw(12) << now
+           << std::setw(10) << std::showpos << (change * 100.0) << "%" << std::noshowpos
+           << (regressed ? "  ❌ 退化" : "  ✅") << "\n";
+    };
+
+    ss << "基线时间: " << baseline.timestamp << "，阈值: " << threshold * 100.0 << "%\n";
+    ss << std::left << std::setw(20) << "指标" << std::right << std::setw(12) << "基线"
+       << std::setw(12) << "当前" << std::setw(11) << "退化" << "\n";
+    check("images/sec", current.images_per_second, baseline.images_per_second, true);
+    check("p50 latency (ms)", current.p50_ms, baseline.p50_ms, false);
+    check("p99 latency (ms)", current.p99_ms, baseline.p99_ms, false);
+    check("peak RSS (MB)", current.peak_rss_mb, baseline.peak_rss_mb, false);
+
+    if (current.corpus_size != baseline.corpus_size) {
+        ss << "⚠️ 语料大小不同 (基线 " << baseline.corpus_size << ", 当前 " << current.corpus_size
+           << ")，对比结果仅供参考\n";
+    }
+
+    report = ss.str();
+    return passed;
+}
+
+double Benchmark::peakResidentMemoryMB() {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        return counters.PeakWorkingSetSize / (1024.0 * 1024.0);
+    }
+    return 0.0;
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0.0;
+    }
+#ifdef __APPLE__
+    return usage.ru_maxrss / (1024.0 * 1024.0);  // bytes
+#else
+    return usage.ru_maxrss / 1024.0;             // kilobytes
+#endif
+#endif
+}
+
+void Benchmark::printResult(const BenchmarkResult& result) {
+    std::cout << "========== 基准测试结果 ==========" << std::endl;
+    std::cout << "语料图像数: " << result.corpus_size << std::endl;
+    std::cout << "计时图像数: " << result.measured_images << std::endl;
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "总耗时: " << result.total_seconds << " s" << std::endl;
+    std::cout << "吞吐量: " << result.images_per_second << " images/sec" << std::endl;
+    std::cout << "延迟: mean " << result.mean_ms << " ms, p50 " << result.p50_ms
+              << " ms, p99 " << result.p99_ms << " ms" << std::endl;
+    std::cout << "峰值常驻内存: " << result.peak_rss_mb << " MB" << std::endl;
+    std::cout << "==================================" << std::endl;
+}
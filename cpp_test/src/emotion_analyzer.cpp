@@ -1,9 +1,12 @@
 #include "emotion_analyzer.h"
 #include "facial_landmarks.h"
+#include "landmark_kernels.h"
 #include "utils.h"
 #include <iostream>
 #include <cmath>
 #include <algorithm>
+#include <chrono>
+#include <future>
 
 #ifndef M_PI
 #define M_PI 3.14159265358979323846
@@ -22,288 +25,1148 @@ EmotionAnalyzer::EmotionAnalyzer(const std::string& onnx_model_path,
                                const std::string& shape_predictor_path)
     : onnx_model_path_(onnx_model_path)
     , frontalization_model_path_(frontalization_model_path)    , shape_predictor_path_(shape_predictor_path)
+    , models_(std::make_shared<ModelSet>())
     , full_features_(false)
     , components_(30)
-#ifdef DLIB_AVAILABLE
-    , face_detector_(dlib::get_frontal_face_detector())
-#endif
 {
 }
 
 EmotionAnalyzer::~EmotionAnalyzer() = default;
 
-bool EmotionAnalyzer::initialize() {
+bool EmotionAnalyzer::initialize(unsigned capabilities) {
     std::cout << "Initializing emotion analyzer..." << std::endl;
     
+#ifndef DLIB_AVAILABLE
+    // Detection can still use the OpenCV cascade backend, landmarks cannot be computed
+    if (capabilities & LANDMARKS) {
+        std::cerr << "Warning: dlib not available - facial landmarks will not be available" << std::endl;
+        capabilities &= ~static_cast<unsigned>(LANDMARKS);
+    }
+#endif
+    
+    // Declared capabilities load now; everything else loads on first use
+    if (!ensureCapabilities(capabilities)) {
+        return false;
+    }
+    
+    std::cout << "Emotion analyzer initialized successfully" << std::endl;
+    return true;
+}
+
+bool EmotionAnalyzer::ensureCapabilities(unsigned capabilities) {
+    struct PendingLoad {
+        const char* name;
+        const LazyModel* model;
+        std::future<bool> done;
+    };
+    
+    // The models are independent, so load them concurrently; the dlib
+    // deserialize dominates and the others finish in its shadow
+    initialization_error_.clear();
+    auto start = std::chrono::steady_clock::now();
+    std::vector<PendingLoad> loads;
+    auto launch = [&](unsigned capability, const char* name, const LazyModel& model,
+                      bool (EmotionAnalyzer::*ensure)()) {
+        if (capabilities & capability) {
+            loads.push_back({name, &model, std::async(std::launch::async, ensure, this)});
+        }
+    };
+    
     try {
-#ifdef ONNX_AVAILABLE
-        // Initialize ONNX Runtime environment with compatibility handling
-        std::cout << "Initializing ONNX Runtime environment..." << std::endl;
+        launch(INFER, "ONNX model", onnx_state_, &EmotionAnalyzer::ensureONNX);
+        launch(FRONTALIZE, "frontalization model", frontalization_state_, &EmotionAnalyzer::ensureFrontalization);
+        launch(DETECT, "face detector", detector_state_, &EmotionAnalyzer::ensureDetector);
+        launch(LANDMARKS, "shape predictor", shape_predictor_state_, &EmotionAnalyzer::ensureShapePredictor);
+    } catch (const std::exception& e) {
+        // Could not start a loader thread; the futures already launched are joined below
+        initialization_error_ = std::string("Failed to start model loading: ") + e.what();
+    }
+    
+    // Wait for every load before reporting, and collect all failures
+    std::vector<std::string> failures;
+    for (auto& load : loads) {
+        bool ok = false;
         try {
-            // Use a more conservative environment initialization
-            ort_env_ = std::make_unique<Ort::Env>(ORT_LOGGING_LEVEL_ERROR, "EmotionAnalyzer");
-            std::cout << "ONNX Runtime environment created successfully" << std::endl;
-            
-            session_options_ = std::make_unique<Ort::SessionOptions>();
-            std::cout << "ONNX Runtime session options created successfully" << std::endl;
-            
-            // Set conservative settings for better compatibility
-            session_options_->SetIntraOpNumThreads(1);
-            session_options_->SetInterOpNumThreads(1);
-            
-            // Disable graph optimization for better compatibility
-            session_options_->SetGraphOptimizationLevel(GraphOptimizationLevel::ORT_DISABLE_ALL);
-            
-            // Disable CPU execution provider extensions that might cause issues
-            session_options_->DisableCpuMemArena();
-            session_options_->DisableMemPattern();
-            
-            std::cout << "ONNX Runtime environment initialized successfully" << std::endl;
-        } catch (const Ort::Exception& e) {
-            std::cerr << "ONNX Runtime exception: " << e.what() << std::endl;
-            return false;
+            ok = load.done.get();
         } catch (const std::exception& e) {
-            std::cerr << "ONNX Runtime initialization failed: " << e.what() << std::endl;
-            return false;
-        } catch (...) {
-            std::cerr << "ONNX Runtime initialization failed: Unknown exception" << std::endl;
+            std::cerr << "Exception while loading " << load.name << ": " << e.what() << std::endl;
+        }
+        if (!ok) {
+            failures.push_back(load.name);
+        }
+    }
+    
+    double total_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    
+    if (!loads.empty()) {
+        std::cout << "Model load times:" << std::endl;
+        for (const auto& load : loads) {
+            std::cout << "  " << load.name << ": " << load.model->load_ms << " ms"
+                      << (load.model->loaded.load(std::memory_order_acquire) ? "" : " (failed)") << std::endl;
+        }
+        std::cout << "  total (parallel): " << total_ms << " ms" << std::endl;
+    }
+    
+    if (!failures.empty()) {
+        initialization_error_ = "Failed to load: " + Utils::joinStrings(failures, ", ");
+    }
+    
+    if (!initialization_error_.empty()) {
+        std::cerr << initialization_error_ << std::endl;
+        return false;
+    }
+    
+    return true;
+}
+
+const std::string& EmotionAnalyzer::getInitializationError() const {
+    return initialization_error_;
+}
+
+unsigned EmotionAnalyzer::loadedCapabilities() const {
+    unsigned capabilities = 0;
+    if (detector_state_.loaded.load(std::memory_order_acquire)) capabilities |= DETECT;
+    if (shape_predictor_state_.loaded.load(std::memory_order_acquire)) capabilities |= LANDMARKS;
+    if (frontalization_state_.loaded.load(std::memory_order_acquire)) capabilities |= FRONTALIZE;
+    if (onnx_state_.loaded.load(std::memory_order_acquire)) capabilities |= INFER;
+    return capabilities;
+}
+
+// Each model loads at most once; concurrent first users block until it is
+// done, and a failed load is not retried. loaded only ever goes from false
+// to true, so a hot reload that published the model also counts
+bool EmotionAnalyzer::ensureModel(LazyModel& model, bool (EmotionAnalyzer::*load)()) {
+    if (model.loaded.load(std::memory_order_acquire)) {
+        return true;
+    }
+    std::call_once(model.once, [&]() {
+        auto start = std::chrono::steady_clock::now();
+        bool loaded = (this->*load)();
+        model.load_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        if (loaded) {
+            model.loaded.store(true, std::memory_order_release);
+        }
+    });
+    return model.loaded.load(std::memory_order_acquire);
+}
+
+bool EmotionAnalyzer::ensureDetector() {
+    return ensureModel(detector_state_, &EmotionAnalyzer::loadFaceDetector);
+}
+
+bool EmotionAnalyzer::ensureShapePredictor() {
+    return ensureModel(shape_predictor_state_, &EmotionAnalyzer::loadShapePredictor);
+}
+
+bool EmotionAnalyzer::ensureFrontalization() {
+    return ensureModel(frontalization_state_, &EmotionAnalyzer::loadFrontalizationModel);
+}
+
+bool EmotionAnalyzer::ensureONNX() {
+    return ensureModel(onnx_state_, &EmotionAnalyzer::loadONNXModel);
+}
+
+std::shared_ptr<const EmotionAnalyzer::ModelSet> EmotionAnalyzer::snapshot() const {
+    return std::atomic_load(&models_);
+}
+
+// Copy-on-write: a published set is never modified, readers holding it are unaffected
+void EmotionAnalyzer::publish(const std::function<void(ModelSet&)>& update) {
+    std::lock_guard<std::mutex> lock(models_mutex_);
+    auto next = std::make_shared<ModelSet>(*std::atomic_load(&models_));
+    update(*next);
+    std::atomic_store(&models_, std::shared_ptr<const ModelSet>(std::move(next)));
+}
+
+std::string EmotionAnalyzer::lockedCopy(const std::string& value) {
+    std::lock_guard<std::mutex> lock(models_mutex_);
+    return value;
+}
+
+uint64_t EmotionAnalyzer::modelGeneration() const {
+    return snapshot()->generation;
+}
+
+bool EmotionAnalyzer::reloadModels(const std::string& onnx_model_path,
+                                   const std::string& frontalization_model_path,
+                                   const std::string& shape_predictor_path) {
+    std::lock_guard<std::mutex> reload_lock(reload_mutex_);
+    auto start = std::chrono::steady_clock::now();
+    
+    // Build the replacements off to the side; analysis keeps running on the current snapshot
+    ModelSet replacement;
+#ifdef ONNX_AVAILABLE
+    if (!onnx_model_path.empty()) {
+        replacement.onnx = buildONNXModel(onnx_model_path);
+        if (!replacement.onnx) {
+            std::cerr << "Hot reload aborted: cannot load " << onnx_model_path << std::endl;
             return false;
         }
-        
-        // Load models
-        std::cout << "Loading ONNX model..." << std::endl;
-        if (!loadONNXModel()) {
-            std::cerr << "Failed to load ONNX model" << std::endl;
+        // One inference on the new session, so the first real request does not pay for its setup
+        std::vector<float> probe(LandmarkKernels::featureCount(full_features_), 0.0f);
+        if (predictWithONNXBatch(replacement, probe.data(), 1, probe.size()).size() < 2) {
+            std::cerr << "Hot reload aborted: " << onnx_model_path << " does not produce arousal/valence" << std::endl;
             return false;
         }
-        std::cout << "ONNX model loaded successfully" << std::endl;
+    }
 #else
-        std::cerr << "ONNX Runtime not available" << std::endl;
+    if (!onnx_model_path.empty()) {
+        std::cerr << "Hot reload aborted: ONNX Runtime not available" << std::endl;
         return false;
+    }
 #endif
-        
-        if (!loadFrontalizationModel()) {
-            std::cerr << "Failed to load frontalization model" << std::endl;
+    
+    if (!frontalization_model_path.empty()) {
+        replacement.frontalization = buildFrontalizationModel(frontalization_model_path);
+        if (!replacement.frontalization) {
+            std::cerr << "Hot reload aborted: cannot load " << frontalization_model_path << std::endl;
             return false;
         }
-        
+    }
+    
+    if (!shape_predictor_path.empty() && !buildShapePredictor(shape_predictor_path, replacement)) {
+        std::cerr << "Hot reload aborted: cannot load " << shape_predictor_path << std::endl;
+        return false;
+    }
+    
+    // New requests take the new set; in-flight ones finish on the snapshot they hold
+    uint64_t generation = 0;
+    publish([&](ModelSet& models) {
+#ifdef ONNX_AVAILABLE
+        if (replacement.onnx) {
+            models.onnx = replacement.onnx;
+            onnx_model_path_ = onnx_model_path;
+        }
+#endif
+        if (replacement.frontalization) {
+            models.frontalization = replacement.frontalization;
+            frontalization_model_path_ = frontalization_model_path;
+        }
+        if (!shape_predictor_path.empty()) {
+            models.ert = replacement.ert;
 #ifdef DLIB_AVAILABLE
-        if (!loadShapePredictor()) {
-            std::cerr << "Failed to load shape predictor" << std::endl;
-            return false;
+            models.dlib_shape = replacement.dlib_shape;
+#endif
+            shape_predictor_path_ = shape_predictor_path;
         }
-#else
-        std::cerr << "Warning: dlib not available - using simple face detection fallback" << std::endl;
+        generation = ++models.generation;
+    });
+    
+    // A reload also recovers a model whose first load failed: the paths gated on it work from now on
+#ifdef ONNX_AVAILABLE
+    if (replacement.onnx) {
+        onnx_state_.loaded.store(true, std::memory_order_release);
+    }
 #endif
-        
-        std::cout << "Emotion analyzer initialized successfully" << std::endl;
+    if (replacement.frontalization) {
+        frontalization_state_.loaded.store(true, std::memory_order_release);
+    }
+    if (!shape_predictor_path.empty()) {
+        shape_predictor_state_.loaded.store(true, std::memory_order_release);
+    }
+    
+    std::cout << "Models reloaded (generation " << generation << ") in "
+              << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count()
+              << " ms" << std::endl;
+    return true;
+}
+
+bool EmotionAnalyzer::loadFaceDetector() {
+    try {
+        std::string error;
+        face_detector_ = FaceDetection::create(detector_config_, error);
+        if (!face_detector_) {
+            std::cerr << error << std::endl;
+            return false;
+        }
+        std::cout << "Face detector backend: " << face_detector_->name() << std::endl;
         return true;
-        
     } catch (const std::exception& e) {
-        std::cerr << "Initialization failed: " << e.what() << std::endl;
+        std::cerr << "Failed to create face detector: " << e.what() << std::endl;
         return false;
     }
 }
 
 bool EmotionAnalyzer::loadONNXModel() {
 #ifdef ONNX_AVAILABLE
-    try {
-        // Load ONNX model
-        #ifdef _WIN32
-        std::wstring wide_path(onnx_model_path_.begin(), onnx_model_path_.end());
-        ort_session_ = std::make_unique<Ort::Session>(*ort_env_, wide_path.c_str(), *session_options_);
-        #else
-        ort_session_ = std::make_unique<Ort::Session>(*ort_env_, onnx_model_path_.c_str(), *session_options_);
-        #endif
-          // Get input/output info
-        auto input_info = ort_session_->GetInputTypeInfo(0);
-        auto tensor_info = input_info.GetTensorTypeAndShapeInfo();
-        auto shape = tensor_info.GetShape();
-          // Get input and output names
-        Ort::AllocatorWithDefaultOptions allocator;
-        auto input_name_ptr = ort_session_->GetInputNameAllocated(0, allocator);
-        auto output_name_ptr = ort_session_->GetOutputNameAllocated(0, allocator);
-        
-        input_name_ = std::string(input_name_ptr.get());
-        output_name_ = std::string(output_name_ptr.get());
-        
-        std::cout << "ONNX model loaded successfully" << std::endl;
-        std::cout << "Input name: " << input_name_ << std::endl;
-        std::cout << "Output name: " << output_name_ << std::endl;
-        std::cout << "Input dimensions: [";
-        for (size_t i = 0; i < shape.size(); ++i) {
-            std::cout << shape[i];
-            if (i < shape.size() - 1) std::cout << ", ";
-        }
-        std::cout << "]" << std::endl;
-        
-        return true;
-        
-    } catch (const std::exception& e) {
-        std::cerr << "Failed to load ONNX model: " << e.what() << std::endl;
-        return false;
+    auto model = buildONNXModel(lockedCopy(onnx_model_path_));
+    if (model) {
+        // A hot reload that already published a model wins
+        publish([&](ModelSet& models) {
+            if (!models.onnx) models.onnx = model;
+        });
     }
+    return model != nullptr;
 #else
     std::cerr << "ONNX Runtime not available" << std::endl;
     return false;
 #endif
 }
 
+#ifdef ONNX_AVAILABLE
+std::shared_ptr<const OnnxModel> EmotionAnalyzer::buildONNXModel(const std::string& path) {
+    // Sessions built with different optimization levels are different models
+    const OnnxSessionConfig config = onnx_session_config_;
+    const std::string kind = "onnx-O" + std::to_string(config.optimization_level);
+    return ModelRegistry::acquire<OnnxModel>(kind, path, [&path, &config]() -> std::shared_ptr<const OnnxModel> {
+        std::cout << "Loading ONNX model..." << std::endl;
+        try {
+            auto start = std::chrono::steady_clock::now();
+            auto model = std::make_shared<OnnxModel>();
+            bool cache_hit = false;
+            model->session = OnnxSessionCache::createSession(path, config, &cache_hit);
+            std::cout << "ONNX session created in " << std::chrono::duration<double, std::milli>(
+                std::chrono::steady_clock::now() - start).count() << " ms"
+                      << (cache_hit ? " (optimized model from cache)" : "") << std::endl;
+            
+              // Get input/output info
+            auto input_info = model->session->GetInputTypeInfo(0);
+            auto tensor_info = input_info.GetTensorTypeAndShapeInfo();
+            auto shape = tensor_info.GetShape();
+              // Get input and output names
+            Ort::AllocatorWithDefaultOptions allocator;
+            auto input_name_ptr = model->session->GetInputNameAllocated(0, allocator);
+            auto output_name_ptr = model->session->GetOutputNameAllocated(0, allocator);
+            
+            model->input_name = std::string(input_name_ptr.get());
+            model->output_name = std::string(output_name_ptr.get());
+            
+            std::cout << "ONNX model loaded successfully" << std::endl;
+            std::cout << "Input name: " << model->input_name << std::endl;
+            std::cout << "Output name: " << model->output_name << std::endl;
+            std::cout << "Input dimensions: [";
+            for (size_t i = 0; i < shape.size(); ++i) {
+                std::cout << shape[i];
+                if (i < shape.size() - 1) std::cout << ", ";
+            }
+            std::cout << "]" << std::endl;
+            
+            return model;
+            
+        } catch (const Ort::Exception& e) {
+            std::cerr << "ONNX Runtime exception: " << e.what() << std::endl;
+            return nullptr;
+        } catch (const std::exception& e) {
+            std::cerr << "Failed to load ONNX model: " << e.what() << std::endl;
+            return nullptr;
+        } catch (...) {
+            std::cerr << "Failed to load ONNX model: Unknown exception" << std::endl;
+            return nullptr;
+        }
+    });
+}
+#endif
+
 bool EmotionAnalyzer::loadFrontalizationModel() {
-    // Load frontalization model from .npy file
-    std::cout << "Loading frontalization model from " << frontalization_model_path_ << std::endl;
+    auto model = buildFrontalizationModel(lockedCopy(frontalization_model_path_));
+    if (model) {
+        publish([&](ModelSet& models) {
+            if (!models.frontalization) models.frontalization = model;
+        });
+    }
+    return model != nullptr;
+}
+
+std::shared_ptr<const FrontalizationModel> EmotionAnalyzer::buildFrontalizationModel(const std::string& path) {
+    return ModelRegistry::acquire<FrontalizationModel>("frontalization", path,
+                                                       [&path]() -> std::shared_ptr<const FrontalizationModel> {
+        // Load frontalization model from .npy file
+        std::cout << "Loading frontalization model from " << path << std::endl;
+        auto model = std::make_shared<FrontalizationModel>();
     
 #ifdef CNPY_AVAILABLE
-    try {
-        cnpy::NpyArray arr = cnpy::npy_load(frontalization_model_path_);
+        try {
+            cnpy::NpyArray arr = cnpy::npy_load(path);
         
-        std::cout << "Loaded array with word_size: " << arr.word_size << std::endl;
+            std::cout << "Loaded array with word_size: " << arr.word_size << std::endl;
         
-        // Expected shape: (137, 136) for DLIB 68 landmarks
-        // 137 = 2*68 + 1 (for intercept), 136 = 2*68
-        if (arr.shape.size() != 2 || arr.shape[0] != 137 || arr.shape[1] != 136) {
-            std::cerr << "Invalid frontalization model shape. Expected (137, 136), got (" 
-                     << arr.shape[0] << ", " << arr.shape[1] << ")" << std::endl;
-            return false;
-        }
+            // Expected shape: (137, 136) for DLIB 68 landmarks
+            // 137 = 2*68 + 1 (for intercept), 136 = 2*68
+            if (arr.shape.size() != 2 || arr.shape[0] != 137 || arr.shape[1] != 136) {
+                std::cerr << "Invalid frontalization model shape. Expected (137, 136), got (" 
+                         << arr.shape[0] << ", " << arr.shape[1] << ")" << std::endl;
+                return nullptr;
+            }
         
-        // Handle both float32 and float64
-        if (arr.word_size == sizeof(double)) {
-            // Convert from float64 to float32
-            double* data = arr.data<double>();
-            frontalization_weights_.reserve(arr.num_vals);
-            for (size_t i = 0; i < arr.num_vals; i++) {
-                frontalization_weights_.push_back(static_cast<float>(data[i]));
+            // Handle both float32 and float64
+            if (arr.word_size == sizeof(double)) {
+                // Convert from float64 to float32
+                double* data = arr.data<double>();
+                model->weights.reserve(arr.num_vals);
+                for (size_t i = 0; i < arr.num_vals; i++) {
+                    model->weights.push_back(static_cast<float>(data[i]));
+                }
+            } else if (arr.word_size == sizeof(float)) {
+                // Use float32 directly
+                float* data = arr.data<float>();
+                model->weights.assign(data, data + arr.num_vals);
+            } else {
+                std::cerr << "Unsupported data type in frontalization model" << std::endl;
+                return nullptr;
             }
-        } else if (arr.word_size == sizeof(float)) {
-            // Use float32 directly
-            float* data = arr.data<float>();
-            frontalization_weights_.assign(data, data + arr.num_vals);
-        } else {
-            std::cerr << "Unsupported data type in frontalization model" << std::endl;
-            return false;
-        }
         
-        std::cout << "Frontalization model loaded successfully" << std::endl;
-        std::cout << "Model shape: (" << arr.shape[0] << ", " << arr.shape[1] << ")" << std::endl;
-        std::cout << "Sample weights: " << frontalization_weights_[0] << ", " 
-                  << frontalization_weights_[1] << ", " << frontalization_weights_[2] << std::endl;
+            model->packed = LandmarkKernels::packWeightPanels(
+                model->weights.data(),
+                LandmarkKernels::kFrontalInputDim,
+                LandmarkKernels::kFrontalOutputDim);
         
-        return true;
+            std::cout << "Frontalization model loaded successfully" << std::endl;
+            std::cout << "Model shape: (" << arr.shape[0] << ", " << arr.shape[1] << ")" << std::endl;
+            std::cout << "Sample weights: " << model->weights[0] << ", " 
+                      << model->weights[1] << ", " << model->weights[2] << std::endl;
         
-    } catch (const std::exception& e) {
-        std::cerr << "Failed to load frontalization model: " << e.what() << std::endl;
-        return false;
-    }
+            return model;
+        
+        } catch (const std::exception& e) {
+            std::cerr << "Failed to load frontalization model: " << e.what() << std::endl;
+            return nullptr;
+        }
 #else
-    std::cout << "CNPY not available, skipping frontalization model loading" << std::endl;
-    // Create a dummy identity-like transformation for fallback
-    frontalization_weights_.resize(137 * 136, 0.0f);
+        std::cout << "CNPY not available, skipping frontalization model loading" << std::endl;
+        // Create a dummy identity-like transformation for fallback
+        model->weights.resize(137 * 136, 0.0f);
     
-    // Set up identity mapping (simplified fallback)
-    for (int i = 0; i < 136; i++) {
-        frontalization_weights_[i * 137 + i] = 1.0f;
-    }
+        // Set up identity mapping (simplified fallback)
+        for (int i = 0; i < 136; i++) {
+            model->weights[i * 137 + i] = 1.0f;
+        }
     
-    return true;
+        model->packed = LandmarkKernels::packWeightPanels(
+            model->weights.data(),
+            LandmarkKernels::kFrontalInputDim,
+            LandmarkKernels::kFrontalOutputDim);
+    
+        return model;
 #endif
+    });
 }
 
 bool EmotionAnalyzer::loadShapePredictor() {
+    ModelSet built;
+    if (!buildShapePredictor(lockedCopy(shape_predictor_path_), built)) {
+        return false;
+    }
+    publish([&](ModelSet& models) {
 #ifdef DLIB_AVAILABLE
-    try {
-        dlib::deserialize(shape_predictor_path_) >> shape_predictor_;
+        if (models.ert || models.dlib_shape) return;
+        models.dlib_shape = built.dlib_shape;
+#else
+        if (models.ert) return;
+#endif
+        models.ert = built.ert;
+    });
+    return true;
+}
+
+bool EmotionAnalyzer::buildShapePredictor(const std::string& path, ModelSet& models) {
+    if (native_shape_predictor_) {
+        models.ert = ModelRegistry::acquire<ErtShapePredictor>("ert", path,
+                                                                [&path]() -> std::shared_ptr<const ErtShapePredictor> {
+            auto predictor = std::make_shared<ErtShapePredictor>();
+            if (!predictor->load(path)) {
+                return nullptr;
+            }
+            return predictor;
+        });
+        if (models.ert) {
+            std::cout << "Shape predictor loaded successfully (native ERT evaluator, "
+                      << models.ert->numCascades() << " cascades)" << std::endl;
+            return true;
+        }
+        std::cerr << "Native shape predictor unavailable, falling back to dlib" << std::endl;
+    }
+    
+#ifdef DLIB_AVAILABLE
+    models.dlib_shape = ModelRegistry::acquire<dlib::shape_predictor>("dlib-shape-predictor", path,
+                                                                      [&path]() -> std::shared_ptr<const dlib::shape_predictor> {
+        try {
+            auto predictor = std::make_shared<dlib::shape_predictor>();
+            dlib::deserialize(path) >> *predictor;
+            return predictor;
+        } catch (const std::exception& e) {
+            std::cerr << "Failed to load shape predictor: " << e.what() << std::endl;
+            return nullptr;
+        }
+    });
+    if (models.dlib_shape) {
         std::cout << "Shape predictor loaded successfully" << std::endl;
-        return true;
-    } catch (const std::exception& e) {
-        std::cerr << "Failed to load shape predictor: " << e.what() << std::endl;
-        return false;
     }
+    return models.dlib_shape != nullptr;
 #else
     std::cerr << "dlib not available for shape predictor" << std::endl;
     return false;
 #endif
 }
 
+bool EmotionAnalyzer::predictShape(const ModelSet& models, const cv::Mat& gray, const cv::Rect& face,
+                                   std::vector<cv::Point2f>& landmarks) const {
+    if (models.ert) {
+        models.ert->predict(gray, face, landmarks, landmark_budget_);
+        return !landmarks.empty();
+    }
+    
+#ifdef DLIB_AVAILABLE
+    if (!models.dlib_shape) {
+        landmarks.clear();
+        return false;
+    }
+    dlib::cv_image<unsigned char> dlib_image(gray);
+    dlib::full_object_detection shape = (*models.dlib_shape)(dlib_image, FaceDetection::toDlibRect(face));
+    landmarks.clear();
+    for (unsigned long i = 0; i < shape.num_parts(); ++i) {
+        landmarks.emplace_back(static_cast<float>(shape.part(i).x()), static_cast<float>(shape.part(i).y()));
+    }
+    return true;
+#else
+    landmarks.clear();
+    return false;
+#endif
+}
+
+bool EmotionAnalyzer::trackShape(const ModelSet& models, const cv::Mat& gray, const cv::Rect& face,
+                                 AnalysisWorkspace& workspace) const {
+    int first_cascade = 0;
+    double scale = 1.0;
+    const cv::Rect& previous = workspace.previous_face;
+    
+    if (!workspace.previous_landmarks.empty() && previous.width > 0 &&
+        workspace.tracked_frames < landmark_tracking_.max_tracked_frames) {
+        scale = static_cast<double>(face.width) / previous.width;
+        const double dx = (face.x + 0.5 * face.width) - (previous.x + 0.5 * previous.width);
+        const double dy = (face.y + 0.5 * face.height) - (previous.y + 0.5 * previous.height);
+        const double motion = std::sqrt(dx * dx + dy * dy) / previous.width + std::abs(std::log(scale));
+        
+        // Split the cascades that actually run: with a budget the tail past budget.cascades never runs
+        const int total = models.ert->numCascades();
+        const int cascades = landmark_budget_.cascades > 0 ? std::min(total, landmark_budget_.cascades) : total;
+        if (motion < landmark_tracking_.small_motion) {
+            first_cascade = cascades * 2 / 3;
+        } else if (motion < landmark_tracking_.large_motion) {
+            first_cascade = cascades / 3;
+        }
+        first_cascade = std::min(first_cascade, std::max(0, cascades - 1));
+    }
+    
+    if (first_cascade > 0) {
+        // Carry the previous shape into this box: same offset from the box centre, scaled with the box
+        const float previous_cx = previous.x + 0.5f * previous.width;
+        const float previous_cy = previous.y + 0.5f * previous.height;
+        const float cx = face.x + 0.5f * face.width;
+        const float cy = face.y + 0.5f * face.height;
+        for (auto& p : workspace.previous_landmarks) {
+            p.x = cx + static_cast<float>((p.x - previous_cx) * scale);
+            p.y = cy + static_cast<float>((p.y - previous_cy) * scale);
+        }
+        models.ert->predictFrom(gray, face, workspace.previous_landmarks, first_cascade,
+                                workspace.raw_landmarks, landmark_budget_);
+        ++workspace.tracked_frames;
+    } else {
+        models.ert->predict(gray, face, workspace.raw_landmarks, landmark_budget_);
+        workspace.tracked_frames = 0;
+    }
+    
+    workspace.first_cascade = first_cascade;
+    workspace.previous_face = face;
+    workspace.previous_landmarks.assign(workspace.raw_landmarks.begin(), workspace.raw_landmarks.end());
+    return !workspace.raw_landmarks.empty();
+}
+
+void EmotionAnalyzer::setLandmarkTracking(const LandmarkTracking& tracking) {
+    landmark_tracking_ = tracking;
+}
+
+const LandmarkTracking& EmotionAnalyzer::getLandmarkTracking() const {
+    return landmark_tracking_;
+}
+
+void EmotionAnalyzer::setOnnxSessionConfig(const OnnxSessionConfig& config) {
+    onnx_session_config_ = config;
+}
+
+const OnnxSessionConfig& EmotionAnalyzer::getOnnxSessionConfig() const {
+    return onnx_session_config_;
+}
+
+void EmotionAnalyzer::setNativeShapePredictor(bool enabled) {
+    native_shape_predictor_ = enabled;
+}
+
+void EmotionAnalyzer::setLandmarkBudget(const ErtBudget& budget) {
+    landmark_budget_ = budget;
+}
+
+const ErtBudget& EmotionAnalyzer::getLandmarkBudget() const {
+    return landmark_budget_;
+}
+
 EmotionResult EmotionAnalyzer::analyzeEmotion(const cv::Mat& image) {
+    LandmarksData landmarks_data;
+    return analyzeEmotion(image, landmarks_data);
+}
+
+EmotionResult EmotionAnalyzer::analyzeEmotion(const cv::Mat& image, LandmarksData& landmarks_data) {
     EmotionResult result;
     result.arousal = 0.0f;
     result.valence = 0.0f;
     result.intensity = 0.0f;
     result.emotion_name = "neutral";
+    result.code = {EmotionLabels::kLabelNeutral, -1};
     
     try {
         // Get facial landmarks
-        auto landmarks_data = getFacialLandmarks(image);
+        landmarks_data = getFacialLandmarks(image);
         
         if (landmarks_data.raw_landmarks.empty()) {
             std::cerr << "No face detected in image" << std::endl;
             return result;
         }
         
-        // Frontalize landmarks
-        auto frontal_landmarks = frontalizeLandmarks(landmarks_data.raw_landmarks);
-        
-        // Extract geometric features
-        auto features = extractGeometricFeatures(frontal_landmarks);
+        // Features and prediction come from one snapshot, so a concurrent reload never pairs
+        // a frontalization model with an emotion model it was not trained with
+        ensureFrontalization();
+#ifdef ONNX_AVAILABLE
+        ensureONNX();
+#endif
+        const auto models = snapshot();
         
-        if (features.empty()) {
+        // Standardize, frontalize and extract geometric features in one pass
+        std::vector<float> features(LandmarkKernels::featureCount(full_features_));
+        if (extractFeaturesFused(*models, landmarks_data.raw_landmarks, features.data(), features.size()) == 0) {
             std::cerr << "Failed to extract features" << std::endl;
             return result;
         }
           // Predict with ONNX model
-        auto prediction = predictWithONNX(features);
+        auto prediction = predictWithONNXBatch(*models, features.data(), 1, features.size());
         
         if (prediction.size() >= 2) {
-            result.arousal = prediction[0];
-            result.valence = prediction[1];
+            fillEmotionResult(prediction[0], prediction[1], result);
+        }
+        
+    } catch (const std::exception& e) {
+        std::cerr << "Error in emotion analysis: " << e.what() << std::endl;
+    }
+    
+    return result;
+}
+
+void EmotionAnalyzer::fillEmotionResult(float arousal, float valence, EmotionResult& result) {
+    result.arousal = arousal;
+    result.valence = valence;
+    
+    // Apply limits to arousal and valence (same as Python)
+    if (result.arousal > 1.0f) result.arousal = 1.0f;
+    else if (result.arousal < -1.0f) result.arousal = -1.0f;
+    
+    if (result.valence > 1.0f) result.valence = 1.0f;
+    else if (result.valence < -1.0f) result.valence = -1.0f;
+    
+    // Calculate intensity as Euclidean distance (same as Python)
+    result.intensity = std::sqrt(result.valence * result.valence + result.arousal * result.arousal);
+    if (result.intensity > 1.0f) result.intensity = 1.0f;
+    else if (result.intensity < 0.0f) result.intensity = 0.0f;
+    
+    // Round to 3 decimal places (same as Python)
+    result.intensity = std::round(result.intensity * 1000.0f) / 1000.0f;
+    
+    result.code = EmotionLabels::fromAVI(result.arousal, result.valence, result.intensity);
+    result.emotion_name.assign(EmotionLabels::label(result.code));
+}
+
+bool EmotionAnalyzer::prepareWorkspace(AnalysisWorkspace& workspace) {
+    workspace.prepared = false;
+    workspace.raw_landmarks.reserve(LandmarkKernels::kNumLandmarks);
+    workspace.features.assign(LandmarkKernels::featureCount(full_features_), 0.0f);
+    workspace.detections.reserve(16);
+    
+    if (!ensureFrontalization()) {
+        std::cerr << "Frontalization model not loaded - cannot prepare workspace" << std::endl;
+        return false;
+    }
+    
+#ifdef ONNX_AVAILABLE
+    if (!ensureONNX()) {
+        std::cerr << "ONNX model not loaded - cannot prepare workspace" << std::endl;
+        return false;
+    }
+#endif
+    
+    workspace.prepared = bindWorkspace(workspace, *snapshot());
+    return workspace.prepared;
+}
+
+bool EmotionAnalyzer::bindWorkspace(AnalysisWorkspace& workspace, const ModelSet& models) {
+#ifdef ONNX_AVAILABLE
+    if (!models.onnx) {
+        return false;
+    }
+    
+    try {
+        // Bind the workspace buffers as the session's input/output tensors once per model generation;
+        // a dynamic batch dimension is fixed to 1
+        workspace.output_shape = models.onnx->session->GetOutputTypeInfo(0).GetTensorTypeAndShapeInfo().GetShape();
+        size_t output_size = 1;
+        for (auto& dim : workspace.output_shape) {
+            if (dim <= 0) dim = 1;
+            output_size *= static_cast<size_t>(dim);
+        }
+        workspace.prediction.assign(output_size, 0.0f);
+        workspace.input_shape = {1, static_cast<int64_t>(workspace.features.size())};
+        
+        auto memory_info = Ort::MemoryInfo::CreateCpu(OrtArenaAllocator, OrtMemTypeDefault);
+        workspace.input_tensor = Ort::Value::CreateTensor<float>(
+            memory_info,
+            workspace.features.data(),
+            workspace.features.size(),
+            workspace.input_shape.data(),
+            workspace.input_shape.size()
+        );
+        workspace.output_tensor = Ort::Value::CreateTensor<float>(
+            memory_info,
+            workspace.prediction.data(),
+            workspace.prediction.size(),
+            workspace.output_shape.data(),
+            workspace.output_shape.size()
+        );
+    } catch (const std::exception& e) {
+        std::cerr << "Failed to bind workspace tensors: " << e.what() << std::endl;
+        return false;
+    }
+#else
+    workspace.prediction.assign(2, 0.0f);
+#endif
+    
+    workspace.model_generation = models.generation;
+    return true;
+}
+
+bool EmotionAnalyzer::analyzeEmotion(const cv::Mat& image, AnalysisWorkspace& workspace, EmotionResult& result) {
+    return analyzeWorkspace(image, nullptr, workspace, result);
+}
+
+bool EmotionAnalyzer::analyzeEmotion(const cv::Mat& image, const cv::Rect& face, AnalysisWorkspace& workspace,
+                                     EmotionResult& result) {
+    return analyzeWorkspace(image, &face, workspace, result);
+}
+
+bool EmotionAnalyzer::analyzeWorkspace(const cv::Mat& image, const cv::Rect* face, AnalysisWorkspace& workspace,
+                                       EmotionResult& result) {
+    if (!workspace.prepared && !prepareWorkspace(workspace)) {
+        return false;
+    }
+    
+    // Detection and landmarks only look at intensity, so gray input is used as is
+    const cv::Mat* gray = &image;
+    if (image.type() != CV_8UC1) {
+        if (!toGray(image, workspace.gray)) {
+            std::cerr << "Unsupported image format: " << image.channels() << " channels" << std::endl;
+            return false;
+        }
+        gray = &workspace.gray;
+    }
+    
+    if (face) {
+        workspace.detection_rung = -1;
+    }
+    const bool found = face ? predictLandmarks(*gray, *face, workspace) : detectLandmarks(*gray, workspace);
+    if (!found) {
+        result.arousal = 0.0f;
+        result.valence = 0.0f;
+        result.intensity = 0.0f;
+        result.emotion_name = "neutral";
+        result.code = {EmotionLabels::kLabelNeutral, -1};
+        return false;
+    }
+    
+    return analyzeLandmarks(workspace.raw_landmarks, workspace, result);
+}
+
+bool EmotionAnalyzer::analyzeLandmarks(const std::vector<cv::Point2f>& raw_landmarks,
+                                       AnalysisWorkspace& workspace, EmotionResult& result) {
+    if (!workspace.prepared && !prepareWorkspace(workspace)) {
+        return false;
+    }
+    
+    // This request runs on one snapshot; a reload after this point only affects the next one.
+    // The output tensor is rebound only when a reload changed the model
+    const auto models = snapshot();
+    if (workspace.model_generation != models->generation && !bindWorkspace(workspace, *models)) {
+        return false;
+    }
+    
+    // Reserve for the longest label once so labels are assigned in place (capacity excludes the terminator)
+    const size_t label_capacity = static_cast<size_t>(EmotionLabels::kMaxLabelLength);
+    if (result.emotion_name.capacity() < label_capacity) {
+        result.emotion_name.reserve(label_capacity);
+    }
+    
+    if (extractFeaturesFused(*models, raw_landmarks, workspace.features.data(), workspace.features.size()) == 0) {
+        return false;
+    }
+    
+    if (!runPrediction(*models, workspace) || workspace.prediction.size() < 2) {
+        return false;
+    }
+    
+    fillEmotionResult(workspace.prediction[0], workspace.prediction[1], result);
+    return true;
+}
+
+bool EmotionAnalyzer::toGray(const cv::Mat& image, cv::Mat& gray) {
+    if (image.type() == CV_8UC1) {
+        image.copyTo(gray);
+        return true;
+    }
+    if (image.type() != CV_8UC3 && image.type() != CV_8UC4) {
+        return false;
+    }
+    
+    // Plain channel average, the same intensity dlib derives from bgr_pixel,
+    // so landmarks match what the color wrapper produced
+    const int channels = image.channels();
+    gray.create(image.rows, image.cols, CV_8UC1);
+    for (int y = 0; y < image.rows; ++y) {
+        const unsigned char* src = image.ptr<unsigned char>(y);
+        unsigned char* dst = gray.ptr<unsigned char>(y);
+        for (int x = 0; x < image.cols; ++x, src += channels) {
+            dst[x] = static_cast<unsigned char>((static_cast<unsigned>(src[0]) + src[1] + src[2]) / 3);
+        }
+    }
+    return true;
+}
+
+bool EmotionAnalyzer::detectLandmarks(const cv::Mat& gray, AnalysisWorkspace& workspace) {
+    workspace.raw_landmarks.clear();
+    workspace.detection_rung = -1;
+    
+#ifdef DLIB_AVAILABLE
+    if (!ensureDetector() || !ensureShapePredictor()) {
+        return false;
+    }
+    
+    try {
+        workspace.detection_rung = face_detector_->detect(gray, workspace.detections);
+        if (workspace.detections.empty()) {
+            // Lost the face, the next one starts from scratch
+            workspace.previous_landmarks.clear();
+            workspace.tracked_frames = 0;
+            return false;
+        }
+        
+        // Detections are sorted by confidence, same face as the vector<rectangle> overload picks
+        return predictLandmarks(gray, workspace.detections[0].rect, workspace);
+    } catch (const std::exception& e) {
+        std::cerr << "Error detecting facial landmarks: " << e.what() << std::endl;
+        return false;
+    }
+#else
+    return false;
+#endif
+}
+
+bool EmotionAnalyzer::predictLandmarks(const cv::Mat& gray, const cv::Rect& face, AnalysisWorkspace& workspace) {
+    workspace.raw_landmarks.clear();
+    if (face.width <= 0 || face.height <= 0 || (face & cv::Rect(0, 0, gray.cols, gray.rows)).empty() ||
+        !ensureShapePredictor()) {
+        return false;
+    }
+    
+    auto start = std::chrono::steady_clock::now();
+    const auto models = snapshot();
+    const bool found = (landmark_tracking_.enabled && models->ert)
+        ? trackShape(*models, gray, face, workspace)
+        : predictShape(*models, gray, face, workspace.raw_landmarks);
+    workspace.landmark_ms = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start).count();
+    return found;
+}
+
+bool EmotionAnalyzer::runPrediction(const ModelSet& models, AnalysisWorkspace& workspace) {
+#ifdef ONNX_AVAILABLE
+    try {
+        const char* input_names[] = {models.onnx->input_name.c_str()};
+        const char* output_names[] = {models.onnx->output_name.c_str()};
+        
+        // Run into the pre-bound output tensor, no output vectors are created
+        models.onnx->session->Run(
+            Ort::RunOptions{nullptr},
+            input_names,
+            &workspace.input_tensor,
+            1,
+            output_names,
+            &workspace.output_tensor,
+            1
+        );
+        return true;
+    } catch (const std::exception& e) {
+        std::cerr << "ONNX prediction failed: " << e.what() << std::endl;
+        return false;
+    }
+#else
+    std::fill(workspace.prediction.begin(), workspace.prediction.end(), 0.0f);
+    return true;
+#endif
+}
+
+std::vector<FaceEmotion> EmotionAnalyzer::analyzeFacesInRects(const cv::Mat& image,
+                                                               const std::vector<cv::Rect>& rects) {
+    std::vector<FaceEmotion> faces(rects.size());
+    for (size_t i = 0; i < rects.size(); ++i) {
+        faces[i].rect = rects[i];
+        faces[i].emotion.arousal = 0.0f;
+        faces[i].emotion.valence = 0.0f;
+        faces[i].emotion.intensity = 0.0f;
+        faces[i].emotion.emotion_name = "neutral";
+    }
+    
+    if (rects.empty()) {
+        return faces;
+    }
+    
+#ifdef DLIB_AVAILABLE
+    // Only the shape predictor is needed, the detector is never loaded on this path
+    if (!ensureShapePredictor()) {
+        return faces;
+    }
+    ensureFrontalization();
+#ifdef ONNX_AVAILABLE
+    ensureONNX();
+#endif
+    // All faces of the frame are analyzed with the same models
+    const auto models = snapshot();
+    
+    try {
+        cv::Mat gray;
+        if (image.type() == CV_8UC1) {
+            gray = image;
+        } else if (!toGray(image, gray)) {
+            std::cerr << "Unsupported image format: " << image.channels() << " channels" << std::endl;
+            return faces;
+        }
+        // Landmarks and features per face, then a single batched inference
+        const size_t feature_dim = LandmarkKernels::featureCount(full_features_);
+        const cv::Rect bounds(0, 0, image.cols, image.rows);
+        std::vector<float> features(rects.size() * feature_dim);
+        std::vector<size_t> batch_faces;
+        batch_faces.reserve(rects.size());
+        
+        for (size_t i = 0; i < rects.size(); ++i) {
+            const cv::Rect& r = rects[i];
+            // Boxes may stick out of the frame, but must overlap it
+            if (r.width <= 0 || r.height <= 0 || (r & bounds).empty()) {
+                continue;
+            }
             
-            // Apply limits to arousal and valence (same as Python)
-            if (result.arousal > 1.0f) result.arousal = 1.0f;
-            else if (result.arousal < -1.0f) result.arousal = -1.0f;
+            auto& landmarks = faces[i].landmarks;
+            if (!predictShape(*models, gray, r, landmarks)) {
+                continue;
+            }
             
-            if (result.valence > 1.0f) result.valence = 1.0f;
-            else if (result.valence < -1.0f) result.valence = -1.0f;
+            float* row = features.data() + batch_faces.size() * feature_dim;
+            if (extractFeaturesFused(*models, landmarks, row, feature_dim) > 0) {
+                batch_faces.push_back(i);
+            }
+        }
+        
+        if (batch_faces.empty()) {
+            return faces;
+        }
+        
+        std::vector<float> predictions = predictWithONNXBatch(*models, features.data(), batch_faces.size(), feature_dim);
+        const size_t columns = predictions.size() / batch_faces.size();
+        if (columns < 2) {
+            std::cerr << "Unexpected batch prediction size: " << predictions.size() << std::endl;
+            return faces;
+        }
+        
+        for (size_t k = 0; k < batch_faces.size(); ++k) {
+            FaceEmotion& face = faces[batch_faces[k]];
+            fillEmotionResult(predictions[k * columns], predictions[k * columns + 1], face.emotion);
+            face.success = true;
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error analyzing face rectangles: " << e.what() << std::endl;
+    }
+#else
+    std::cerr << "dlib not available - cannot detect facial landmarks" << std::endl;
+#endif
+    
+    return faces;
+}
+
+WarmupReport EmotionAnalyzer::warmup(int iterations, cv::Size typical_size, AnalysisWorkspace* workspace) {
+    WarmupReport report;
+    
+    if (iterations <= 0 || typical_size.width <= 0 || typical_size.height <= 0) {
+        std::cerr << "Invalid warmup parameters" << std::endl;
+        return report;
+    }
+    
+    // A fixed noise frame: the detector walks its full pyramid and finds nothing,
+    // so the landmark stage runs on a centered box instead
+    cv::Mat frame(typical_size, CV_8UC3);
+    cv::RNG rng(12345);
+    rng.fill(frame, cv::RNG::UNIFORM, 0, 256);
+    
+    const int box = std::min(typical_size.width, typical_size.height) / 2;
+    const int left = (typical_size.width - box) / 2;
+    const int top = (typical_size.height - box) / 2;
+    const cv::Rect center(left, top, box, box);
+    const std::vector<cv::Rect> rects = {center};
+    
+    // The caller's workspace gets its buffers and tensor bindings here instead of on the first request
+    AnalysisWorkspace local_workspace;
+    AnalysisWorkspace& ws = workspace ? *workspace : local_workspace;
+    EmotionResult result;
+    
+    // Stand-in landmarks when no shape predictor is available
+    std::vector<cv::Point2f> landmarks;
+    for (int i = 0; i < LandmarkKernels::kNumLandmarks; ++i) {
+        float angle = static_cast<float>(2.0 * M_PI * i / LandmarkKernels::kNumLandmarks);
+        landmarks.emplace_back(left + box * (0.5f + 0.4f * std::cos(angle)),
+                               top + box * (0.5f + 0.4f * std::sin(angle)));
+    }
+    
+    const double steady_tolerance = 0.10;
+    double previous_ms = 0.0;
+    
+    try {
+        for (int it = 1; it <= iterations; ++it) {
+            auto start = std::chrono::steady_clock::now();
+            
+            // Workspace path with detection: on noise the detector walks its full pyramid
+            analyzeEmotion(frame, ws, result);
+            
+            // Landmarks and the pre-bound inference of the workspace path on the centered box
+            if (!analyzeEmotion(frame, center, ws, result)) {
+                analyzeLandmarks(landmarks, ws, result);
+            }
             
-            // Calculate intensity as Euclidean distance (same as Python)
-            result.intensity = std::sqrt(result.valence * result.valence + result.arousal * result.arousal);
-            if (result.intensity > 1.0f) result.intensity = 1.0f;
-            else if (result.intensity < 0.0f) result.intensity = 0.0f;
+            // Batched inference used by the rectangle interface
+            analyzeFacesInRects(frame, rects);
             
-            // Round to 3 decimal places (same as Python)
-            result.intensity = std::round(result.intensity * 1000.0f) / 1000.0f;
+            double elapsed_ms = std::chrono::duration<double, std::milli>(
+                std::chrono::steady_clock::now() - start).count();
             
-            result.emotion_name = aviToEmotionName(result.arousal, result.valence, result.intensity);
+            report.iterations_run = it;
+            report.steady_ms = elapsed_ms;
+            if (it == 1) {
+                report.first_ms = elapsed_ms;
+            } else if (report.steady_state_iteration < 0 &&
+                       std::abs(elapsed_ms - previous_ms) <= steady_tolerance * previous_ms) {
+                // Two consecutive rounds within the tolerance
+                report.steady_state_iteration = it;
+            }
+            previous_ms = elapsed_ms;
         }
-        
     } catch (const std::exception& e) {
-        std::cerr << "Error in emotion analysis: " << e.what() << std::endl;
+        std::cerr << "Warmup failed: " << e.what() << std::endl;
+        return report;
     }
     
-    return result;
+    // The synthetic frames are not a video, the first real frame must not warm-start from them
+    ws.previous_landmarks.clear();
+    ws.tracked_frames = 0;
+    
+    report.success = true;
+    std::cout << "Warmup: " << report.iterations_run << " iterations at "
+              << typical_size.width << "x" << typical_size.height
+              << ", first " << report.first_ms << " ms, last " << report.steady_ms << " ms";
+    if (report.steady_state_iteration > 0) {
+        std::cout << ", steady state reached at iteration " << report.steady_state_iteration << std::endl;
+    } else {
+        std::cout << ", steady state not reached" << std::endl;
+    }
+    
+    return report;
+}
+
+void EmotionAnalyzer::setDetectorConfig(const DetectorConfig& config) {
+    const bool backend_changed = config.backend != detector_config_.backend ||
+                                 config.cascade_path != detector_config_.cascade_path;
+    detector_config_ = config;
+    if (!detector_state_.loaded) {
+        return;
+    }
+    
+    if (!backend_changed) {
+        face_detector_->setConfig(config);
+        return;
+    }
+    
+    // Switching backends swaps the loaded detector; keep the old one if the new one fails
+    std::string error;
+    std::unique_ptr<FaceDetector> detector = FaceDetection::create(config, error);
+    if (detector) {
+        face_detector_ = std::move(detector);
+    } else {
+        std::cerr << error << " - keeping " << face_detector_->name() << std::endl;
+    }
+}
+
+const DetectorConfig& EmotionAnalyzer::getDetectorConfig() const {
+    return detector_config_;
+}
+
+std::string EmotionAnalyzer::getDetectorName() const {
+    return detector_state_.loaded ? face_detector_->name() : "";
+}
+
+DetectorStats EmotionAnalyzer::getDetectorStats() const {
+    return detector_state_.loaded ? face_detector_->stats() : DetectorStats();
+}
+
+std::vector<DetectedFace> EmotionAnalyzer::detectFaces(const cv::Mat& image) {
+    std::vector<DetectedFace> faces;
+    
+    if (!ensureDetector()) {
+        return faces;
+    }
+    
+    try {
+        cv::Mat gray;
+        if (image.type() == CV_8UC1) {
+            gray = image;
+        } else if (!toGray(image, gray)) {
+            std::cerr << "Unsupported image format: " << image.channels() << " channels" << std::endl;
+            return faces;
+        }
+        face_detector_->detect(gray, faces);
+    } catch (const std::exception& e) {
+        std::cerr << "Error detecting faces: " << e.what() << std::endl;
+    }
+    
+    return faces;
 }
 
 LandmarksData EmotionAnalyzer::getFacialLandmarks(const cv::Mat& image) {
     LandmarksData result;
     
 #ifdef DLIB_AVAILABLE
+    if (!ensureDetector() || !ensureShapePredictor()) {
+        return result;
+    }
+    
     try {
-        dlib::cv_image<dlib::bgr_pixel> dlib_image(image);
-        std::vector<dlib::rectangle> faces = face_detector_(dlib_image);
+        cv::Mat gray;
+        if (image.type() == CV_8UC1) {
+            gray = image;
+        } else if (!toGray(image, gray)) {
+            std::cerr << "Unsupported image format: " << image.channels() << " channels" << std::endl;
+            return result;
+        }
+        
+        std::vector<DetectedFace> faces;
+        result.detection_rung = face_detector_->detect(gray, faces);
         
         if (!faces.empty()) {
-            dlib::full_object_detection landmarks = shape_predictor_(dlib_image, faces[0]);
+            predictShape(*snapshot(), gray, faces[0].rect, result.raw_landmarks);
             
-            std::cout << "Detected " << landmarks.num_parts() << " landmarks:" << std::endl;
+            std::cout << "Detected " << result.raw_landmarks.size() << " landmarks:" << std::endl;
             
-            for (int i = 0; i < landmarks.num_parts(); ++i) {
-                dlib::point p = landmarks.part(i);
-                result.raw_landmarks.push_back(cv::Point2f(p.x(), p.y()));
-                
-                // Print first few landmarks for debugging
-                if (i < 10) {
-                    std::cout << "  Landmark " << i << ": (" << p.x() << ", " << p.y() << ")" << std::endl;
-                }
+            // Print first few landmarks for debugging
+            for (size_t i = 0; i < result.raw_landmarks.size() && i < 10; ++i) {
+                const cv::Point2f& p = result.raw_landmarks[i];
+                std::cout << "  Landmark " << i << ": (" << p.x << ", " << p.y << ")" << std::endl;
             }
         } else {
             std::cout << "No faces detected" << std::endl;
@@ -313,17 +1176,8 @@ LandmarksData EmotionAnalyzer::getFacialLandmarks(const cv::Mat& image) {
         std::cerr << "Error detecting facial landmarks: " << e.what() << std::endl;
     }
 #else
+    // Faces can still be detected with the cascade backend, but there is no landmark model
     std::cerr << "dlib not available - cannot detect facial landmarks" << std::endl;
-    // Fallback: create dummy landmarks for center of image
-    int height = image.rows;
-    int width = image.cols;
-    float cx = width / 2.0f;
-    float cy = height / 2.0f;
-    
-    // Create 68 dummy landmarks arranged in a rough face shape
-    for (int i = 0; i < 68; ++i) {
-        result.raw_landmarks.push_back(cv::Point2f(cx, cy));
-    }
 #endif
     
     return result;
@@ -331,7 +1185,8 @@ LandmarksData EmotionAnalyzer::getFacialLandmarks(const cv::Mat& image) {
 
 std::vector<cv::Point2f> EmotionAnalyzer::frontalizeLandmarks(const std::vector<cv::Point2f>& landmarks) {
     // Implement frontalization using the loaded model
-    if (landmarks.size() != 68 || frontalization_weights_.empty()) {
+    const auto models = landmarks.size() == 68 && ensureFrontalization() ? snapshot() : nullptr;
+    if (!models || !models->frontalization) {
         std::cout << "Frontalization not available, using original landmarks" << std::endl;
         return landmarks; // Return original landmarks if no model
     }
@@ -371,9 +1226,9 @@ std::vector<cv::Point2f> EmotionAnalyzer::frontalizeLandmarks(const std::vector<
     
     for (int i = 0; i < 136; i++) {
         for (int j = 0; j < 137; j++) {
-            // frontalization_weights_ is stored in row-major order
-            // weights[j][i] = frontalization_weights_[j * 136 + i]
-            frontal_vector[i] += feature_vector[j] * frontalization_weights_[j * 136 + i];
+            // frontalization weights are stored in row-major order
+            // weights[j][i] = frontalization->weights[j * 136 + i]
+            frontal_vector[i] += feature_vector[j] * models->frontalization->weights[j * 136 + i];
         }
     }
     
@@ -399,6 +1254,73 @@ std::vector<cv::Point2f> EmotionAnalyzer::frontalizeLandmarks(const std::vector<
     return frontal_landmarks;
 }
 
+std::vector<std::vector<cv::Point2f>> EmotionAnalyzer::frontalizeLandmarksBatch(
+    const std::vector<std::vector<cv::Point2f>>& landmarks_batch) {
+    using namespace LandmarkKernels;
+    
+    const auto models = ensureFrontalization() ? snapshot() : nullptr;
+    if (!models || !models->frontalization) {
+        std::cout << "Frontalization not available, using original landmarks" << std::endl;
+        return landmarks_batch;
+    }
+    
+    std::vector<std::vector<cv::Point2f>> results(landmarks_batch.size());
+    
+    // Step 1: Stack the standardized feature rows of all valid faces into an N x 137 matrix
+    // Row format matches frontalizeLandmarks: [x1..x68, y1..y68, 1]
+    std::vector<size_t> row_to_face;
+    row_to_face.reserve(landmarks_batch.size());
+    std::vector<float> feature_rows;
+    feature_rows.reserve(landmarks_batch.size() * kFrontalInputDim);
+    
+    for (size_t f = 0; f < landmarks_batch.size(); ++f) {
+        const auto& landmarks = landmarks_batch[f];
+        if (landmarks.size() != static_cast<size_t>(kNumLandmarks)) {
+            results[f] = landmarks; // Same fallback as the single-face path
+            continue;
+        }
+        
+        feature_rows.resize(feature_rows.size() + kFrontalInputDim);
+        standardizeToFeatureRow(reinterpret_cast<const float*>(landmarks.data()),
+                                feature_rows.data() + feature_rows.size() - kFrontalInputDim);
+        row_to_face.push_back(f);
+    }
+    
+    if (row_to_face.empty()) {
+        return results;
+    }
+    
+    // Step 2: One cache-blocked GEMM against the packed weights instead of N GEMVs
+    const int rows = static_cast<int>(row_to_face.size());
+    std::vector<float> frontal_rows(static_cast<size_t>(rows) * kFrontalOutputDim);
+    
+    if (blasAvailable()) {
+        gemm(rows, kFrontalOutputDim, kFrontalInputDim,
+             feature_rows.data(), kFrontalInputDim,
+             models->frontalization->weights.data(), kFrontalOutputDim,
+             frontal_rows.data(), kFrontalOutputDim);
+    } else {
+        gemmPacked(rows, kFrontalOutputDim, kFrontalInputDim,
+                   feature_rows.data(), kFrontalInputDim,
+                   models->frontalization->packed.data(),
+                   frontal_rows.data(), kFrontalOutputDim);
+    }
+    
+    // Step 3: Convert each output row back to landmark points
+    for (int r = 0; r < rows; ++r) {
+        const float* frontal_vector = frontal_rows.data() + static_cast<size_t>(r) * kFrontalOutputDim;
+        auto& frontal_landmarks = results[row_to_face[r]];
+        frontal_landmarks.reserve(kNumLandmarks);
+        for (int i = 0; i < kNumLandmarks; i++) {
+            frontal_landmarks.push_back(cv::Point2f(frontal_vector[i], frontal_vector[i + kNumLandmarks]));
+        }
+    }
+    
+    std::cout << "Applied batched frontalization to " << rows << " faces" << std::endl;
+    
+    return results;
+}
+
 std::vector<float> EmotionAnalyzer::extractGeometricFeatures(const std::vector<cv::Point2f>& landmarks) {
     std::vector<float> features;
     
@@ -478,6 +1400,31 @@ std::vector<float> EmotionAnalyzer::extractGeometricFeatures(const std::vector<c
     return features;
 }
 
+int EmotionAnalyzer::extractFeaturesFused(const std::vector<cv::Point2f>& raw_landmarks,
+                                          float* features, size_t capacity) {
+    if (!ensureFrontalization()) {
+        return 0;
+    }
+    return extractFeaturesFused(*snapshot(), raw_landmarks, features, capacity);
+}
+
+int EmotionAnalyzer::extractFeaturesFused(const ModelSet& models, const std::vector<cv::Point2f>& raw_landmarks,
+                                          float* features, size_t capacity) {
+    static_assert(sizeof(cv::Point2f) == 2 * sizeof(float), "cv::Point2f must be two packed floats");
+    
+    if (raw_landmarks.size() != static_cast<size_t>(LandmarkKernels::kNumLandmarks) ||
+        !models.frontalization ||
+        capacity < static_cast<size_t>(LandmarkKernels::featureCount(full_features_))) {
+        return 0;
+    }
+    
+    return LandmarkKernels::computeModelFeatures(
+        reinterpret_cast<const float*>(raw_landmarks.data()),
+        models.frontalization->weights.data(),
+        full_features_,
+        features);
+}
+
 float EmotionAnalyzer::calculateScale(const std::vector<cv::Point2f>& landmarks, const std::vector<int>& landmark_indices) {
     // Compute scale as mean euclidean distance of all landmarks to the mean landmark
     // This matches the Python get_scale function
@@ -512,26 +1459,47 @@ float EmotionAnalyzer::calculateScale(const std::vector<cv::Point2f>& landmarks,
 }
 
 std::vector<float> EmotionAnalyzer::predictWithONNX(const std::vector<float>& features) {
+    return predictWithONNXBatch(features.data(), 1, features.size());
+}
+
+std::vector<float> EmotionAnalyzer::predictWithONNXBatch(const float* features, size_t batch_size, size_t feature_dim) {
+#ifdef ONNX_AVAILABLE
+    if (!ensureONNX()) {
+        return {};
+    }
+#endif
+    return predictWithONNXBatch(*snapshot(), features, batch_size, feature_dim);
+}
+
+std::vector<float> EmotionAnalyzer::predictWithONNXBatch(const ModelSet& models, const float* features,
+                                                         size_t batch_size, size_t feature_dim) {
     std::vector<float> result;
+    if (batch_size == 0) {
+        return result;
+    }
     
 #ifdef ONNX_AVAILABLE
+    if (!models.onnx) {
+        return result;
+    }
+    
     try {
-        // Create input tensor
-        std::vector<int64_t> input_shape = {1, static_cast<int64_t>(features.size())};
+        // The exported model has a dynamic batch dimension
+        std::vector<int64_t> input_shape = {static_cast<int64_t>(batch_size), static_cast<int64_t>(feature_dim)};
         
         auto memory_info = Ort::MemoryInfo::CreateCpu(OrtArenaAllocator, OrtMemTypeDefault);
         Ort::Value input_tensor = Ort::Value::CreateTensor<float>(
             memory_info, 
-            const_cast<float*>(features.data()), 
-            features.size(),
+            const_cast<float*>(features), 
+            batch_size * feature_dim,
             input_shape.data(), 
             input_shape.size()
         );
           // Run inference
-        std::vector<const char*> input_names = {input_name_.c_str()};
-        std::vector<const char*> output_names = {output_name_.c_str()};
+        std::vector<const char*> input_names = {models.onnx->input_name.c_str()};
+        std::vector<const char*> output_names = {models.onnx->output_name.c_str()};
         
-        auto output_tensors = ort_session_->Run(
+        auto output_tensors = models.onnx->session->Run(
             Ort::RunOptions{nullptr}, 
             input_names.data(),
             &input_tensor, 
@@ -557,137 +1525,22 @@ std::vector<float> EmotionAnalyzer::predictWithONNX(const std::vector<float>& fe
 #else
     std::cerr << "ONNX Runtime not available - cannot make predictions" << std::endl;
     // Return dummy values
-    result = {0.0f, 0.0f}; // arousal, valence
+    result.assign(batch_size * 2, 0.0f); // arousal, valence per row
 #endif
     
     return result;
 }
 
 std::string EmotionAnalyzer::aviToEmotionName(float arousal, float valence, float intensity) {
-    // Exact implementation of Python's avi_to_text function
-    // Based on Russell's Circumplex Model of Affect
-    
-    std::vector<std::string> ls_expr_intensity = {
-        "Slightly", "Moderately", "Very", "Extremely"
-    };
-    
-    std::vector<std::string> ls_expr_name = {
-        "pleased", "happy", "delighted", "excited", "astonished", 
-        "aroused", // first quarter
-        
-        "tensed", "alarmed", "afraid", "annoyed", "distressed", 
-        "frustrated", "miserable", // second quarter
-        
-        "sad", "gloomy", "depressed", "bored", "droopy", "tired", 
-        "sleepy", // third quarter
-        
-        "calm", "serene", "content", "satisfied"  // fourth quarter
-    };
-    
-    std::string expression_intensity = "";
-    std::string expression_name = "";
-    
-    // If intensity not provided, calculate it
-    if (intensity < 0) {
-        intensity = std::sqrt(arousal * arousal + valence * valence);
-    }
-    
-    // Analyzing intensity
-    if (intensity < 0.1f) {
-        expression_name = "Neutral";
-        expression_intensity = "";
-    } else {
-        // Determine intensity level
-        if (intensity < 0.325f) {
-            expression_intensity = ls_expr_intensity[0];
-        } else if (intensity < 0.55f) {
-            expression_intensity = ls_expr_intensity[1];
-        } else if (intensity < 0.775f) {
-            expression_intensity = ls_expr_intensity[2];
-        } else {
-            expression_intensity = ls_expr_intensity[3];
-        }
-        
-        // Analyzing expression name - compute angle [0,360]
-        float theta;
-        if (valence == 0.0f) {
-            if (arousal >= 0.0f) {
-                theta = 90.0f;
-            } else {
-                theta = 270.0f;
-            }
-        } else {
-            theta = std::atan(arousal / valence);
-            theta = theta * (180.0f / M_PI);
-            
-            if (valence < 0.0f) {
-                theta = 180.0f + theta;
-            } else if (arousal < 0.0f) {
-                theta = 360.0f + theta;
-            }
-        }
-        
-        // Estimate expression name based on theta ranges (same as Python)
-        if (theta < 16.0f || theta > 354.0f) {
-            expression_name = ls_expr_name[0];  // pleased
-        } else if (theta < 34.0f) {
-            expression_name = ls_expr_name[1];  // happy
-        } else if (theta < 62.5f) {
-            expression_name = ls_expr_name[2];  // delighted
-        } else if (theta < 78.5f) {
-            expression_name = ls_expr_name[3];  // excited
-        } else if (theta < 93.0f) {
-            expression_name = ls_expr_name[4];  // astonished
-        } else if (theta < 104.0f) {
-            expression_name = ls_expr_name[5];  // aroused
-        } else if (theta < 115.0f) {
-            expression_name = ls_expr_name[6];  // tensed
-        } else if (theta < 126.0f) {
-            expression_name = ls_expr_name[7];  // alarmed
-        } else if (theta < 137.0f) {
-            expression_name = ls_expr_name[8];  // afraid
-        } else if (theta < 148.0f) {
-            expression_name = ls_expr_name[9];  // annoyed
-        } else if (theta < 159.0f) {
-            expression_name = ls_expr_name[10]; // distressed
-        } else if (theta < 170.0f) {
-            expression_name = ls_expr_name[11]; // frustrated
-        } else if (theta < 181.0f) {
-            expression_name = ls_expr_name[12]; // miserable
-        } else if (theta < 192.0f) {
-            expression_name = ls_expr_name[13]; // sad
-        } else if (theta < 203.0f) {
-            expression_name = ls_expr_name[14]; // gloomy
-        } else if (theta < 215.0f) {
-            expression_name = ls_expr_name[15]; // depressed
-        } else if (theta < 230.0f) {
-            expression_name = ls_expr_name[16]; // bored
-        } else if (theta < 245.0f) {
-            expression_name = ls_expr_name[17]; // droopy
-        } else if (theta < 260.0f) {
-            expression_name = ls_expr_name[18]; // tired
-        } else if (theta < 280.0f) {
-            expression_name = ls_expr_name[19]; // sleepy
-        } else if (theta < 300.0f) {
-            expression_name = ls_expr_name[20]; // calm
-        } else if (theta < 320.0f) {
-            expression_name = ls_expr_name[21]; // serene
-        } else if (theta < 340.0f) {
-            expression_name = ls_expr_name[22]; // content
-        } else if (theta < 354.0f) {
-            expression_name = ls_expr_name[23]; // satisfied
-        } else {
-            expression_name = "Unknown";
-            expression_intensity = "";
-        }
-    }
-    
-    // Return combined expression (same format as Python)
-    if (expression_intensity.empty()) {
-        return expression_name;
-    } else {
-        return expression_intensity + " " + expression_name;
-    }
+    std::string emotion_name;
+    aviToEmotionName(arousal, valence, intensity, emotion_name);
+    return emotion_name;
+}
+
+void EmotionAnalyzer::aviToEmotionName(float arousal, float valence, float intensity, std::string& emotion_name) {
+    // Exact implementation of Python's avi_to_text function, driven by the
+    // sector table; the label is an interned string so this only copies chars
+    emotion_name.assign(EmotionLabels::label(EmotionLabels::fromAVI(arousal, valence, intensity)));
 }
 
 float EmotionAnalyzer::calculateDistance(const cv::Point2f& p1, const cv::Point2f& p2) {
@@ -0,0 +1,88 @@
+#include "emotion_labels.h"
+#include <array>
+#include <cmath>
+#include <string>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+namespace EmotionLabels {
+
+namespace {
+
+// 全部 "强度 + 名称" 组合只在首次使用时拼接一次
+const std::array<std::string, kNumSectors * kNumIntensityLevels>& internedLabels() {
+    static const auto labels = [] {
+        std::array<std::string, kNumSectors * kNumIntensityLevels> table;
+        for (int sector = 0; sector < kNumSectors; ++sector) {
+            for (int level = 0; level < kNumIntensityLevels; ++level) {
+                table[sector * kNumIntensityLevels + level] =
+                    std::string(kIntensityNames[level]) + " " + kSectors[sector].name;
+            }
+        }
+        return table;
+    }();
+    return labels;
+}
+
+} // namespace
+
+EmotionCode fromAVI(float arousal, float valence, float intensity) {
+    // If intensity not provided, calculate it
+    if (intensity < 0) {
+        intensity = std::sqrt(arousal * arousal + valence * valence);
+    }
+
+    if (intensity < kNeutralThreshold) {
+        return {kLabelNeutral, -1};
+    }
+
+    int level = kNumIntensityLevels - 1;
+    for (int i = 0; i < kNumIntensityLevels - 1; ++i) {
+        if (intensity < kIntensityUpperBounds[i]) {
+            level = i;
+            break;
+        }
+    }
+
+    // Angle in [0,360), computed exactly as Python's avi_to_text does
+    float theta;
+    if (valence == 0.0f) {
+        theta = (arousal >= 0.0f) ? 90.0f : 270.0f;
+    } else {
+        theta = std::atan(arousal / valence);
+        theta = theta * (180.0f / M_PI);
+
+        if (valence < 0.0f) {
+            theta = 180.0f + theta;
+        } else if (arousal < 0.0f) {
+            theta = 360.0f + theta;
+        }
+    }
+
+    if (theta > kSectors[kNumSectors - 1].upper_bound) {
+        return {0, level};  // wraps around to "pleased"
+    }
+    for (int sector = 0; sector < kNumSectors; ++sector) {
+        if (theta < kSectors[sector].upper_bound) {
+            return {sector, level};
+        }
+    }
+
+    // Only reachable for theta == 354 or NaN
+    return {kLabelUnknown, -1};
+}
+
+const char* label(EmotionCode code) {
+    if (code.quadrant_label_id == kLabelNeutral) {
+        return "Neutral";
+    }
+    if (code.quadrant_label_id < 0 || code.quadrant_label_id >= kNumSectors ||
+        code.intensity_level < 0 || code.intensity_level >= kNumIntensityLevels) {
+        return "Unknown";
+    }
+    return internedLabels()[code.quadrant_label_id * kNumIntensityLevels + code.intensity_level].c_str();
+}
+
+} // namespace EmotionLabels
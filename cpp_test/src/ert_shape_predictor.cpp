@@ -0,0 +1,517 @@
+#include "ert_shape_predictor.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+#ifdef DLIB_AVAILABLE
+#include <dlib/image_processing/shape_predictor.h>
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define ERT_SSE2 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define ERT_NEON 1
+#endif
+
+namespace {
+
+// current[0..dim) += the leaves of every tree, added in tree order so each coordinate sums
+// exactly as dlib does. Columns go in blocks of 16 floats held in four vector registers across
+// all trees, so the shape is loaded and stored once per cascade instead of once per tree
+void accumulateLeaves(float* current, const float* leaves, const int* leaf_index, int num_trees,
+                      int leaves_per_tree, int dim) {
+    const size_t tree_stride = static_cast<size_t>(leaves_per_tree) * dim;
+    int j = 0;
+#if defined(ERT_SSE2)
+    for (; j + 16 <= dim; j += 16) {
+        __m128 s0 = _mm_loadu_ps(current + j);
+        __m128 s1 = _mm_loadu_ps(current + j + 4);
+        __m128 s2 = _mm_loadu_ps(current + j + 8);
+        __m128 s3 = _mm_loadu_ps(current + j + 12);
+        for (int t = 0; t < num_trees; ++t) {
+            const float* leaf = leaves + t * tree_stride + static_cast<size_t>(leaf_index[t]) * dim + j;
+            s0 = _mm_add_ps(s0, _mm_loadu_ps(leaf));
+            s1 = _mm_add_ps(s1, _mm_loadu_ps(leaf + 4));
+            s2 = _mm_add_ps(s2, _mm_loadu_ps(leaf + 8));
+            s3 = _mm_add_ps(s3, _mm_loadu_ps(leaf + 12));
+        }
+        _mm_storeu_ps(current + j, s0);
+        _mm_storeu_ps(current + j + 4, s1);
+        _mm_storeu_ps(current + j + 8, s2);
+        _mm_storeu_ps(current + j + 12, s3);
+    }
+    for (; j + 4 <= dim; j += 4) {
+        __m128 s = _mm_loadu_ps(current + j);
+        for (int t = 0; t < num_trees; ++t) {
+            s = _mm_add_ps(s, _mm_loadu_ps(leaves + t * tree_stride + static_cast<size_t>(leaf_index[t]) * dim + j));
+        }
+        _mm_storeu_ps(current + j, s);
+    }
+#elif defined(ERT_NEON)
+    for (; j + 16 <= dim; j += 16) {
+        float32x4_t s0 = vld1q_f32(current + j);
+        float32x4_t s1 = vld1q_f32(current + j + 4);
+        float32x4_t s2 = vld1q_f32(current + j + 8);
+        float32x4_t s3 = vld1q_f32(current + j + 12);
+        for (int t = 0; t < num_trees; ++t) {
+            const float* leaf = leaves + t * tree_stride + static_cast<size_t>(leaf_index[t]) * dim + j;
+            s0 = vaddq_f32(s0, vld1q_f32(leaf));
+            s1 = vaddq_f32(s1, vld1q_f32(leaf + 4));
+            s2 = vaddq_f32(s2, vld1q_f32(leaf + 8));
+            s3 = vaddq_f32(s3, vld1q_f32(leaf + 12));
+        }
+        vst1q_f32(current + j, s0);
+        vst1q_f32(current + j + 4, s1);
+        vst1q_f32(current + j + 8, s2);
+        vst1q_f32(current + j + 12, s3);
+    }
+    for (; j + 4 <= dim; j += 4) {
+        float32x4_t s = vld1q_f32(current + j);
+        for (int t = 0; t < num_trees; ++t) {
+            s = vaddq_f32(s, vld1q_f32(leaves + t * tree_stride + static_cast<size_t>(leaf_index[t]) * dim + j));
+        }
+        vst1q_f32(current + j, s);
+    }
+#endif
+    for (; j < dim; ++j) {
+        float s = current[j];
+        for (int t = 0; t < num_trees; ++t) {
+            s += leaves[t * tree_stride + static_cast<size_t>(leaf_index[t]) * dim + j];
+        }
+        current[j] = s;
+    }
+}
+
+// Flat model file: a header, then 64-byte aligned arrays addressed by byte offsets from the
+// start of the file. Native byte order; the same layout is built in memory when loading a .dat
+constexpr char kFlatMagic[8] = {'E', 'R', 'T', 'F', 'L', 'A', 'T', '\0'};
+constexpr uint32_t kFlatVersion = 1;
+constexpr size_t kFlatAlignment = 64;
+
+struct FlatHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t parts;
+    uint32_t cascades;
+    uint32_t splits_per_tree;
+    uint64_t initial_shape;    // float[2 * parts]
+    uint64_t cascade_table;    // FlatCascade[cascades]
+    uint64_t size;             // total bytes
+    uint8_t reserved[16];
+};
+
+struct FlatCascade {
+    uint32_t features;
+    uint32_t num_trees;
+    uint64_t anchor;           // int32[features]
+    uint64_t delta_x;          // float[features]
+    uint64_t delta_y;          // float[features]
+    uint64_t splits;           // Split[num_trees * splits_per_tree]
+    uint64_t leaves;           // float[num_trees * (splits_per_tree + 1) * 2 * parts]
+};
+
+size_t alignUp(size_t bytes) {
+    return (bytes + kFlatAlignment - 1) & ~(kFlatAlignment - 1);
+}
+
+// Assigns offsets for a model with the given per-cascade (features, trees); returns the total size
+size_t layoutFlat(uint32_t parts, uint32_t splits_per_tree, size_t split_bytes,
+                  std::vector<FlatCascade>& cascades, FlatHeader& header) {
+    const size_t dim = 2 * static_cast<size_t>(parts);
+    size_t offset = alignUp(sizeof(FlatHeader));
+    header.initial_shape = offset;
+    offset = alignUp(offset + dim * sizeof(float));
+    header.cascade_table = offset;
+    offset = alignUp(offset + cascades.size() * sizeof(FlatCascade));
+    for (auto& cascade : cascades) {
+        cascade.anchor = offset;
+        offset = alignUp(offset + cascade.features * sizeof(int32_t));
+        cascade.delta_x = offset;
+        offset = alignUp(offset + cascade.features * sizeof(float));
+        cascade.delta_y = offset;
+        offset = alignUp(offset + cascade.features * sizeof(float));
+        cascade.splits = offset;
+        offset = alignUp(offset + static_cast<size_t>(cascade.num_trees) * splits_per_tree * split_bytes);
+        cascade.leaves = offset;
+        offset = alignUp(offset + static_cast<size_t>(cascade.num_trees) * (splits_per_tree + 1) * dim * sizeof(float));
+    }
+    header.size = offset;
+    return offset;
+}
+
+bool inRange(uint64_t offset, uint64_t bytes, size_t size) {
+    return offset % alignof(float) == 0 && offset <= size && bytes <= size - offset;
+}
+
+}  // namespace
+
+bool ErtShapePredictor::load(const std::string& path) {
+    ErtShapePredictor loaded;
+    const bool ok = isFlatFile(path) ? loaded.loadFlat(path) : loaded.loadDlib(path);
+    if (ok) {
+        *this = std::move(loaded);
+    }
+    return ok;
+}
+
+bool ErtShapePredictor::isFlatFile(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    char magic[sizeof(kFlatMagic)] = {};
+    return in.read(magic, sizeof(magic)) && std::memcmp(magic, kFlatMagic, sizeof(magic)) == 0;
+}
+
+bool ErtShapePredictor::loadFlat(const std::string& path) {
+    auto mapping = std::make_unique<MappedFile>();
+    if (!mapping->open(path)) {
+        return false;
+    }
+    if (!bind(mapping->data(), mapping->size())) {
+        std::cerr << "Malformed flat shape predictor: " << path << std::endl;
+        return false;
+    }
+    mapping_ = std::move(mapping);
+    return true;
+}
+
+bool ErtShapePredictor::loadDlib(const std::string& path) {
+#ifdef DLIB_AVAILABLE
+    try {
+        std::ifstream in(path, std::ios::binary);
+        if (!in.is_open()) {
+            std::cerr << "Cannot open shape predictor: " << path << std::endl;
+            return false;
+        }
+
+        // Same fields, in the same order, as dlib::shape_predictor's deserialize
+        int version = 0;
+        dlib::matrix<float, 0, 1> initial_shape;
+        std::vector<std::vector<dlib::impl::regression_tree>> forests;
+        std::vector<std::vector<unsigned long>> anchor_idx;
+        std::vector<std::vector<dlib::vector<float, 2>>> deltas;
+        dlib::deserialize(version, in);
+        if (version != 1) {
+            std::cerr << "Unsupported shape predictor version: " << version << std::endl;
+            return false;
+        }
+        dlib::deserialize(initial_shape, in);
+        dlib::deserialize(forests, in);
+        dlib::deserialize(anchor_idx, in);
+        dlib::deserialize(deltas, in);
+
+        const long dim = initial_shape.size();
+        if (dim == 0 || dim % 2 != 0 || forests.empty() ||
+            anchor_idx.size() != forests.size() || deltas.size() != forests.size()) {
+            std::cerr << "Malformed shape predictor: " << path << std::endl;
+            return false;
+        }
+
+        // The flat layout needs every tree to be complete and of the same depth
+        std::vector<FlatCascade> table(forests.size());
+        int splits_per_tree = -1;
+        for (size_t c = 0; c < forests.size(); ++c) {
+            const size_t features = anchor_idx[c].size();
+            if (deltas[c].size() != features || features > 0xFFFF) {
+                std::cerr << "Unsupported feature layout in cascade " << c << std::endl;
+                return false;
+            }
+            for (const auto& tree : forests[c]) {
+                if (splits_per_tree < 0) {
+                    splits_per_tree = static_cast<int>(tree.splits.size());
+                }
+                if (static_cast<int>(tree.splits.size()) != splits_per_tree ||
+                    tree.leaf_values.size() != tree.splits.size() + 1) {
+                    std::cerr << "Trees of different depths are not supported" << std::endl;
+                    return false;
+                }
+                for (const auto& leaf : tree.leaf_values) {
+                    if (leaf.size() != dim) {
+                        std::cerr << "Leaf size does not match the shape" << std::endl;
+                        return false;
+                    }
+                }
+            }
+            table[c].features = static_cast<uint32_t>(features);
+            table[c].num_trees = static_cast<uint32_t>(forests[c].size());
+        }
+
+        FlatHeader header = {};
+        std::memcpy(header.magic, kFlatMagic, sizeof(kFlatMagic));
+        header.version = kFlatVersion;
+        header.parts = static_cast<uint32_t>(dim / 2);
+        header.cascades = static_cast<uint32_t>(forests.size());
+        header.splits_per_tree = static_cast<uint32_t>(std::max(0, splits_per_tree));
+        const size_t size = layoutFlat(header.parts, header.splits_per_tree, sizeof(Split), table, header);
+
+        std::vector<uint64_t> owned((size + sizeof(uint64_t) - 1) / sizeof(uint64_t), 0);
+        unsigned char* image = reinterpret_cast<unsigned char*>(owned.data());
+        std::memcpy(image, &header, sizeof(header));
+        std::memcpy(image + header.cascade_table, table.data(), table.size() * sizeof(FlatCascade));
+
+        float* initial = reinterpret_cast<float*>(image + header.initial_shape);
+        for (long j = 0; j < dim; ++j) {
+            initial[j] = initial_shape(j);
+        }
+
+        for (size_t c = 0; c < forests.size(); ++c) {
+            const FlatCascade& entry = table[c];
+            int32_t* anchor = reinterpret_cast<int32_t*>(image + entry.anchor);
+            float* delta_x = reinterpret_cast<float*>(image + entry.delta_x);
+            float* delta_y = reinterpret_cast<float*>(image + entry.delta_y);
+            for (size_t i = 0; i < entry.features; ++i) {
+                anchor[i] = static_cast<int32_t>(std::min<unsigned long>(anchor_idx[c][i], 0x7FFFFFFF));
+                delta_x[i] = deltas[c][i].x();
+                delta_y[i] = deltas[c][i].y();
+            }
+
+            Split* splits = reinterpret_cast<Split*>(image + entry.splits);
+            float* leaves = reinterpret_cast<float*>(image + entry.leaves);
+            for (const auto& tree : forests[c]) {
+                for (const auto& split : tree.splits) {
+                    *splits++ = {static_cast<uint16_t>(std::min<unsigned long>(split.idx1, 0xFFFF)),
+                                 static_cast<uint16_t>(std::min<unsigned long>(split.idx2, 0xFFFF)), split.thresh};
+                }
+                for (const auto& leaf : tree.leaf_values) {
+                    for (long j = 0; j < dim; ++j) {
+                        *leaves++ = leaf(j);
+                    }
+                }
+            }
+        }
+
+        // Anchors and split indices are range-checked here, on the same path as mapped files
+        if (!bind(image, size)) {
+            std::cerr << "Malformed shape predictor: " << path << std::endl;
+            return false;
+        }
+        owned_ = std::move(owned);
+        return true;
+    } catch (const std::exception& e) {
+        std::cerr << "Failed to load shape predictor: " << e.what() << std::endl;
+        return false;
+    }
+#else
+    std::cerr << "dlib not available - cannot read shape predictor " << path
+              << " (export a flat model with a dlib build)" << std::endl;
+    return false;
+#endif
+}
+
+bool ErtShapePredictor::bind(const unsigned char* image, size_t size) {
+    FlatHeader header;
+    if (size < sizeof(header)) {
+        return false;
+    }
+    std::memcpy(&header, image, sizeof(header));
+    if (std::memcmp(header.magic, kFlatMagic, sizeof(kFlatMagic)) != 0 || header.version != kFlatVersion ||
+        header.size != size || header.parts == 0 || header.cascades == 0 || header.splits_per_tree > 30) {
+        return false;
+    }
+
+    const size_t dim = 2 * static_cast<size_t>(header.parts);
+    const size_t leaves_per_tree = header.splits_per_tree + 1;
+    if (!inRange(header.initial_shape, dim * sizeof(float), size) ||
+        header.cascade_table % alignof(uint64_t) != 0 ||
+        !inRange(header.cascade_table, static_cast<uint64_t>(header.cascades) * sizeof(FlatCascade), size)) {
+        return false;
+    }
+
+    std::vector<Cascade> cascades(header.cascades);
+    const FlatCascade* table = reinterpret_cast<const FlatCascade*>(image + header.cascade_table);
+    for (uint32_t c = 0; c < header.cascades; ++c) {
+        const FlatCascade& entry = table[c];
+        const uint64_t split_count = static_cast<uint64_t>(entry.num_trees) * header.splits_per_tree;
+        if (entry.features > 0xFFFF || entry.num_trees > 0xFFFFFF ||
+            !inRange(entry.anchor, entry.features * sizeof(int32_t), size) ||
+            !inRange(entry.delta_x, entry.features * sizeof(float), size) ||
+            !inRange(entry.delta_y, entry.features * sizeof(float), size) ||
+            !inRange(entry.splits, split_count * sizeof(Split), size) ||
+            !inRange(entry.leaves, static_cast<uint64_t>(entry.num_trees) * leaves_per_tree * dim * sizeof(float), size)) {
+            return false;
+        }
+
+        Cascade& cascade = cascades[c];
+        cascade.anchor = reinterpret_cast<const int32_t*>(image + entry.anchor);
+        cascade.delta_x = reinterpret_cast<const float*>(image + entry.delta_x);
+        cascade.delta_y = reinterpret_cast<const float*>(image + entry.delta_y);
+        cascade.splits = reinterpret_cast<const Split*>(image + entry.splits);
+        cascade.leaves = reinterpret_cast<const float*>(image + entry.leaves);
+        cascade.features = static_cast<int>(entry.features);
+        cascade.num_trees = static_cast<int>(entry.num_trees);
+
+        for (int i = 0; i < cascade.features; ++i) {
+            if (cascade.anchor[i] < 0 || static_cast<uint32_t>(cascade.anchor[i]) >= header.parts) {
+                return false;
+            }
+        }
+        for (uint64_t i = 0; i < split_count; ++i) {
+            if (cascade.splits[i].idx1 >= entry.features || cascade.splits[i].idx2 >= entry.features) {
+                return false;
+            }
+        }
+    }
+
+    const float* initial = reinterpret_cast<const float*>(image + header.initial_shape);
+    float mean_x = 0.0f, mean_y = 0.0f;
+    for (uint32_t i = 0; i < header.parts; ++i) {
+        mean_x += initial[2 * i];
+        mean_y += initial[2 * i + 1];
+    }
+    mean_x /= header.parts;
+    mean_y /= header.parts;
+
+    initial_centered_.resize(dim);
+    initial_norm_ = 0.0f;
+    for (uint32_t i = 0; i < header.parts; ++i) {
+        initial_centered_[2 * i] = initial[2 * i] - mean_x;
+        initial_centered_[2 * i + 1] = initial[2 * i + 1] - mean_y;
+        initial_norm_ += initial_centered_[2 * i] * initial_centered_[2 * i] +
+                         initial_centered_[2 * i + 1] * initial_centered_[2 * i + 1];
+    }
+
+    image_ = image;
+    image_size_ = size;
+    initial_shape_ = initial;
+    dim_ = static_cast<int>(dim);
+    cascades_ = std::move(cascades);
+    splits_per_tree_ = static_cast<int>(header.splits_per_tree);
+    leaves_per_tree_ = splits_per_tree_ + 1;
+    return true;
+}
+
+bool ErtShapePredictor::saveFlat(const std::string& path) const {
+    if (empty()) {
+        std::cerr << "No shape predictor loaded" << std::endl;
+        return false;
+    }
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out.is_open()) {
+        std::cerr << "Cannot write flat shape predictor: " << path << std::endl;
+        return false;
+    }
+    out.write(reinterpret_cast<const char*>(image_), static_cast<std::streamsize>(image_size_));
+    if (!out) {
+        std::cerr << "Failed to write flat shape predictor: " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void ErtShapePredictor::predict(const cv::Mat& gray, const cv::Rect& face,
+                                std::vector<cv::Point2f>& landmarks, const ErtBudget& budget) const {
+    evaluate(gray, face, nullptr, 0, landmarks, budget);
+}
+
+void ErtShapePredictor::predictFrom(const cv::Mat& gray, const cv::Rect& face,
+                                    const std::vector<cv::Point2f>& start, int first_cascade,
+                                    std::vector<cv::Point2f>& landmarks, const ErtBudget& budget) const {
+    if (static_cast<int>(start.size()) != numParts()) {
+        evaluate(gray, face, nullptr, 0, landmarks, budget);
+        return;
+    }
+    evaluate(gray, face, &start, std::max(0, first_cascade), landmarks, budget);
+}
+
+void ErtShapePredictor::evaluate(const cv::Mat& gray, const cv::Rect& face,
+                                 const std::vector<cv::Point2f>* start, int first_cascade,
+                                 std::vector<cv::Point2f>& landmarks, const ErtBudget& budget) const {
+    if (empty() || gray.empty() || gray.type() != CV_8UC1) {
+        landmarks.clear();
+        return;
+    }
+
+    const int dim = dim_;
+    const int parts = dim / 2;
+
+    // dlib maps the unit square onto the box corners: (0, 0) -> (left, top), (1, 1) -> (right, bottom)
+    const double left = face.x;
+    const double top = face.y;
+    const double span_x = face.width - 1;
+    const double span_y = face.height - 1;
+
+    // Per-thread buffers, sized on the first call
+    thread_local std::vector<float> shape;
+    thread_local std::vector<float> pixels;
+    thread_local std::vector<int> leaf_index;
+    if (start) {
+        // Warm start: the given points expressed in this box's unit square (start may alias landmarks)
+        shape.resize(dim);
+        for (int i = 0; i < parts; ++i) {
+            shape[2 * i] = static_cast<float>(span_x > 0.0 ? ((*start)[i].x - left) / span_x : 0.0);
+            shape[2 * i + 1] = static_cast<float>(span_y > 0.0 ? ((*start)[i].y - top) / span_y : 0.0);
+        }
+    } else {
+        shape.assign(initial_shape_, initial_shape_ + dim);
+    }
+    landmarks.clear();
+
+    const size_t num_cascades = budget.cascades > 0
+        ? std::min(cascades_.size(), static_cast<size_t>(budget.cascades))
+        : cascades_.size();
+
+    for (size_t c = static_cast<size_t>(first_cascade); c < num_cascades; ++c) {
+        const Cascade& cascade = cascades_[c];
+        const int num_trees = budget.trees > 0 ? std::min(cascade.num_trees, budget.trees) : cascade.num_trees;
+
+        // Least-squares similarity from the mean shape to the current shape; in 2D its
+        // rotation-and-scale part is [a -b; b a]
+        float mean_x = 0.0f, mean_y = 0.0f;
+        for (int i = 0; i < parts; ++i) {
+            mean_x += shape[2 * i];
+            mean_y += shape[2 * i + 1];
+        }
+        mean_x /= parts;
+        mean_y /= parts;
+
+        float dot = 0.0f, cross = 0.0f;
+        for (int i = 0; i < parts; ++i) {
+            const float fx = initial_centered_[2 * i];
+            const float fy = initial_centered_[2 * i + 1];
+            const float tx = shape[2 * i] - mean_x;
+            const float ty = shape[2 * i + 1] - mean_y;
+            dot += fx * tx + fy * ty;
+            cross += fx * ty - fy * tx;
+        }
+        const float a = initial_norm_ > 0.0f ? dot / initial_norm_ : 1.0f;
+        const float b = initial_norm_ > 0.0f ? cross / initial_norm_ : 0.0f;
+
+        // Gather every pixel feature of this cascade in one pass; outside the image reads as 0
+        const size_t features = static_cast<size_t>(cascade.features);
+        pixels.resize(features);
+        for (size_t i = 0; i < features; ++i) {
+            const int k = cascade.anchor[i];
+            const float dx = cascade.delta_x[i];
+            const float dy = cascade.delta_y[i];
+            const float px = a * dx - b * dy + shape[2 * k];
+            const float py = b * dx + a * dy + shape[2 * k + 1];
+            const long x = static_cast<long>(std::floor(left + px * span_x + 0.5));
+            const long y = static_cast<long>(std::floor(top + py * span_y + 0.5));
+            pixels[i] = (x >= 0 && y >= 0 && x < gray.cols && y < gray.rows)
+                ? static_cast<float>(gray.ptr<unsigned char>(static_cast<int>(y))[x])
+                : 0.0f;
+        }
+
+        // Walk all trees first, then add their leaves in tree order
+        leaf_index.resize(num_trees);
+        const Split* splits = cascade.splits;
+        for (int t = 0; t < num_trees; ++t, splits += splits_per_tree_) {
+            int node = 0;
+            while (node < splits_per_tree_) {
+                const Split& split = splits[node];
+                node = (pixels[split.idx1] - pixels[split.idx2] > split.thresh) ? 2 * node + 1 : 2 * node + 2;
+            }
+            leaf_index[t] = node - splits_per_tree_;
+        }
+
+        accumulateLeaves(shape.data(), cascade.leaves, leaf_index.data(), num_trees, leaves_per_tree_, dim);
+    }
+
+    // Back to image coordinates, rounded to whole pixels like dlib's full_object_detection
+    for (int i = 0; i < parts; ++i) {
+        landmarks.emplace_back(static_cast<float>(std::floor(left + shape[2 * i] * span_x + 0.5)),
+                               static_cast<float>(std::floor(top + shape[2 * i + 1] * span_y + 0.5)));
+    }
+}
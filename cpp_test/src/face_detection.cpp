@@ -0,0 +1,394 @@
+#include "face_detection.h"
+#include "model_registry.h"
+#include <algorithm>
+#include <cmath>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <thread>
+
+bool DetectorConfig::usesBuiltinPyramid() const {
+    return backend == DetectorBackend::Hog && !ladder && tile_size <= 0 && min_face_size <= 0 && max_face_size <= 0 && upsample <= 0 &&
+           std::abs(pyramid_ratio - 5.0 / 6.0) < 1e-9;
+}
+
+namespace FaceDetection {
+
+double intersectionOverUnion(const cv::Rect& a, const cv::Rect& b) {
+    const double intersection = (a & b).area();
+    const double union_area = static_cast<double>(a.area()) + b.area() - intersection;
+    return union_area > 0.0 ? intersection / union_area : 0.0;
+}
+
+void nonMaxSuppression(std::vector<DetectedFace>& faces, double iou_threshold) {
+    std::sort(faces.begin(), faces.end(), [](const DetectedFace& a, const DetectedFace& b) {
+        return a.confidence > b.confidence;
+    });
+
+    size_t kept = 0;
+    for (size_t i = 0; i < faces.size(); ++i) {
+        bool suppressed = false;
+        for (size_t k = 0; k < kept && !suppressed; ++k) {
+            suppressed = intersectionOverUnion(faces[i].rect, faces[k].rect) > iou_threshold;
+        }
+        if (!suppressed) {
+            faces[kept++] = faces[i];
+        }
+    }
+    faces.resize(kept);
+}
+
+std::vector<double> pyramidScales(cv::Size image_size, const DetectorConfig& config) {
+    std::vector<double> scales;
+
+    // A face of side s is found at the level where s * scale matches the detection window
+    double scale = config.min_face_size > 0
+        ? static_cast<double>(kWindowSize) / config.min_face_size
+        : std::pow(2.0, std::max(0, config.upsample));
+    const double min_scale = config.max_face_size > 0
+        ? static_cast<double>(kWindowSize) / config.max_face_size
+        : 0.0;
+    const double ratio = (config.pyramid_ratio > 0.0 && config.pyramid_ratio < 1.0)
+        ? config.pyramid_ratio
+        : 5.0 / 6.0;
+    const int short_side = std::min(image_size.width, image_size.height);
+
+    while (scale >= min_scale && short_side * scale >= kWindowSize) {
+        scales.push_back(scale);
+        scale *= ratio;
+    }
+    return scales;
+}
+
+int detectionThreads(cv::Size image_size, const DetectorConfig& config) {
+    if (image_size.area() < kParallelMinPixels) {
+        return 1;
+    }
+    if (config.threads > 0) {
+        return config.threads;
+    }
+    return std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+}
+
+std::unique_ptr<FaceDetector> create(const DetectorConfig& config, std::string& error) {
+    std::unique_ptr<FaceDetector> detector;
+
+    if (config.backend == DetectorBackend::Hog) {
+#ifdef DLIB_AVAILABLE
+        detector = std::make_unique<HogFaceDetector>();
+#else
+        error = "dlib not available - HOG face detector unavailable";
+        return nullptr;
+#endif
+    } else {
+        auto cascade = std::make_unique<CascadeFaceDetector>();
+        if (!cascade->load(config.cascade_path)) {
+            error = "Failed to load face cascade: " + config.cascade_path;
+            return nullptr;
+        }
+        detector = std::move(cascade);
+    }
+
+    detector->setConfig(config);
+    return detector;
+}
+
+bool parseBackend(const std::string& name, DetectorConfig& config) {
+    if (name == "hog") {
+        config.backend = DetectorBackend::Hog;
+    } else if (name == "haar") {
+        config.backend = DetectorBackend::Cascade;
+        config.cascade_path = kHaarCascadeFile;
+    } else if (name == "lbp") {
+        config.backend = DetectorBackend::Cascade;
+        config.cascade_path = kLbpCascadeFile;
+    } else if (name.size() > 4 && name.compare(name.size() - 4, 4, ".xml") == 0) {
+        config.backend = DetectorBackend::Cascade;
+        config.cascade_path = name;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+} // namespace FaceDetection
+
+int FaceDetector::detect(const cv::Mat& gray, std::vector<DetectedFace>& faces) {
+    auto start = std::chrono::steady_clock::now();
+    faces.clear();
+    int rung = detectImpl(gray, faces);
+    stats_.last_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    stats_.total_ms += stats_.last_ms;
+    ++stats_.calls;
+    return rung;
+}
+
+bool CascadeFaceDetector::load(const std::string& cascade_path) {
+    try {
+        return classifier_.load(cascade_path) && !classifier_.empty();
+    } catch (const cv::Exception& e) {
+        std::cerr << "Failed to load face cascade: " << e.what() << std::endl;
+        return false;
+    }
+}
+
+int CascadeFaceDetector::detectImpl(const cv::Mat& gray, std::vector<DetectedFace>& faces) {
+    if (!config_.ladder) {
+        int min_size = config_.min_face_size;
+        if (min_size <= 0 && config_.upsample > 0) {
+            min_size = FaceDetection::kWindowSize >> std::min(config_.upsample, 4);
+        }
+        detectRange(gray, min_size, config_.max_face_size, faces);
+        FaceDetection::nonMaxSuppression(faces);
+        return faces.empty() ? -1 : 0;
+    }
+
+    // Same ladder as the HOG backend: each rung covers [min face, previous rung's min face)
+    for (size_t rung = 0; rung < config_.ladder_min_faces.size(); ++rung) {
+        const int max_size = rung > 0 ? config_.ladder_min_faces[rung - 1] - 1 : config_.max_face_size;
+        detectRange(gray, config_.ladder_min_faces[rung], max_size, faces);
+        if (!faces.empty()) {
+            FaceDetection::nonMaxSuppression(faces);
+            return static_cast<int>(rung);
+        }
+    }
+    return -1;
+}
+
+void CascadeFaceDetector::detectRange(const cv::Mat& gray, int min_size, int max_size,
+                                      std::vector<DetectedFace>& faces) {
+    const double ratio = (config_.pyramid_ratio > 0.0 && config_.pyramid_ratio < 1.0)
+        ? config_.pyramid_ratio
+        : 5.0 / 6.0;
+    classifier_.detectMultiScale(gray, objects_, neighbors_, 1.0 / ratio, std::max(1, config_.min_neighbors), 0,
+                                 min_size > 0 ? cv::Size(min_size, min_size) : cv::Size(),
+                                 max_size > 0 ? cv::Size(max_size, max_size) : cv::Size());
+    for (size_t i = 0; i < objects_.size(); ++i) {
+        faces.push_back({objects_[i], i < neighbors_.size() ? static_cast<double>(neighbors_[i]) : 0.0});
+    }
+}
+
+#ifdef DLIB_AVAILABLE
+
+HogFaceDetector::HogFaceDetector()
+    : prototype_(ModelRegistry::frontalFaceDetector())
+    , detector_(*prototype_) {
+    // Same weights, but the scanner only looks at the image it is given;
+    // the pyramid is built here so its ratio and range can be configured
+    auto scanner = detector_.get_scanner();
+    scanner.set_max_pyramid_levels(1);
+    std::vector<dlib::frontal_face_detector::feature_vector_type> weights;
+    for (unsigned long i = 0; i < detector_.num_detectors(); ++i) {
+        weights.push_back(detector_.get_w(i));
+    }
+    single_level_ = dlib::frontal_face_detector(scanner, detector_.get_overlap_tester(), weights);
+}
+
+int HogFaceDetector::detectImpl(const cv::Mat& gray, std::vector<DetectedFace>& faces) {
+    if (config_.usesBuiltinPyramid() && FaceDetection::detectionThreads(gray.size(), config_) <= 1) {
+        dlib::cv_image<unsigned char> dlib_image(gray);
+        detector_(dlib_image, scratch_, config_.threshold);
+        for (const auto& det : scratch_) {
+            faces.push_back({cv::Rect(det.rect.left(), det.rect.top(), det.rect.width(), det.rect.height()),
+                             det.detection_confidence});
+        }
+        // dlib already sorted and suppressed overlaps
+        return faces.empty() ? -1 : 0;
+    }
+
+    if (!config_.ladder) {
+        detectLevels(gray, FaceDetection::pyramidScales(gray.size(), config_), faces);
+        FaceDetection::nonMaxSuppression(faces);
+        return faces.empty() ? -1 : 0;
+    }
+
+    // Each rung only scans the levels between its own smallest face and the previous rung's,
+    // so a miss costs no more than a single pass at the smallest size
+    DetectorConfig rung_config = config_;
+    rung_config.upsample = 0;
+    for (size_t rung = 0; rung < config_.ladder_min_faces.size(); ++rung) {
+        rung_config.min_face_size = config_.ladder_min_faces[rung];
+        if (rung > 0) {
+            rung_config.max_face_size = config_.ladder_min_faces[rung - 1];
+        }
+
+        scales_ = FaceDetection::pyramidScales(gray.size(), rung_config);
+        if (rung > 0 && !scales_.empty()) {
+            const double covered = static_cast<double>(FaceDetection::kWindowSize) / rung_config.max_face_size;
+            while (!scales_.empty() && scales_.back() <= covered) {
+                scales_.pop_back();
+            }
+        }
+
+        detectLevels(gray, scales_, faces);
+        if (!faces.empty()) {
+            FaceDetection::nonMaxSuppression(faces);
+            return static_cast<int>(rung);
+        }
+    }
+    return -1;
+}
+
+void HogFaceDetector::detectLevels(const cv::Mat& gray, const std::vector<double>& scales,
+                                   std::vector<DetectedFace>& faces) {
+    if (scales.empty()) {
+        return;
+    }
+
+    const int threads = FaceDetection::detectionThreads(gray.size(), config_);
+    if (config_.tile_size > 0 && (gray.cols > config_.tile_size || gray.rows > config_.tile_size)) {
+        detectTiles(gray, scales, threads, faces);
+        return;
+    }
+    if (threads > 1) {
+        detectLevelsParallel(gray, scales, threads, faces);
+        return;
+    }
+
+    for (double scale : scales) {
+        const cv::Mat* level = &gray;
+        if (scale != 1.0) {
+            resizeLevel(gray, scale, level_);
+            level = &level_;
+        }
+
+        dlib::cv_image<unsigned char> dlib_image(*level);
+        single_level_(dlib_image, scratch_, config_.threshold);
+        appendDetections(scratch_, cv::Point(), scale, faces);
+    }
+}
+
+void HogFaceDetector::detectLevelsParallel(const cv::Mat& gray, const std::vector<double>& scales, int threads,
+                                           std::vector<DetectedFace>& faces) {
+    // Build every level up front; cv::resize is itself parallel
+    levels_.resize(scales.size());
+    double total_area = 0.0;
+    for (size_t i = 0; i < scales.size(); ++i) {
+        if (scales[i] != 1.0) {
+            resizeLevel(gray, scales[i], levels_[i]);
+        }
+        total_area += static_cast<double>(gray.cols) * gray.rows * scales[i] * scales[i];
+    }
+
+    // The largest level alone is about a third of the work, so big levels are cut into
+    // overlapping row strips until no task is much larger than a thread's fair share
+    const double target_area = total_area / (2.0 * threads);
+    const int overlap = FaceDetection::kStripOverlap;
+    tasks_.clear();
+    for (size_t i = 0; i < scales.size(); ++i) {
+        const cv::Mat& level = scales[i] != 1.0 ? levels_[i] : gray;
+        int strips = static_cast<int>(std::ceil(level.total() / target_area));
+        strips = std::max(1, std::min(strips, level.rows / (2 * overlap)));
+        const int step = (level.rows + strips - 1) / strips;
+        for (int s = 0; s < strips; ++s) {
+            const int top = s * step;
+            const int bottom = std::min(level.rows, top + step + overlap);
+            tasks_.push_back({i, cv::Rect(0, top, level.cols, bottom - top)});
+        }
+    }
+    // Largest tasks first so the tail is made of small ones
+    std::stable_sort(tasks_.begin(), tasks_.end(), [](const ScanTask& a, const ScanTask& b) {
+        return a.roi.area() > b.roi.area();
+    });
+
+    runTasks(threads, faces, [&](Worker& worker, const ScanTask& task) {
+        const double scale = scales[task.level];
+        const cv::Mat& level = scale != 1.0 ? levels_[task.level] : gray;
+        dlib::cv_image<unsigned char> dlib_image(level(task.roi));
+        worker.detector(dlib_image, worker.scratch, config_.threshold);
+        appendDetections(worker.scratch, task.roi.tl(), scale, worker.faces);
+    });
+    // Faces in the overlap of two strips are found twice; the caller's NMS merges them
+}
+
+void HogFaceDetector::detectTiles(const cv::Mat& gray, const std::vector<double>& scales, int threads,
+                                  std::vector<DetectedFace>& faces) {
+    // Tiles of the source image; each worker builds the pyramid of one tile at a time
+    // into its own buffer, so working memory follows the tile size, not the image size
+    const int tile = std::max(config_.tile_size, 2 * FaceDetection::kWindowSize);
+    const int overlap = std::max(0, std::min(config_.tile_overlap, tile / 2));
+    const int step = tile - overlap;
+
+    auto positions = [&](int length) {
+        std::vector<int> starts;
+        for (int start = 0; ; start += step) {
+            if (start + tile >= length) {
+                starts.push_back(std::max(0, length - tile));  // last tile flush with the edge
+                break;
+            }
+            starts.push_back(start);
+        }
+        return starts;
+    };
+
+    tasks_.clear();
+    for (int y : positions(gray.rows)) {
+        for (int x : positions(gray.cols)) {
+            tasks_.push_back({0, cv::Rect(x, y, std::min(tile, gray.cols - x), std::min(tile, gray.rows - y))});
+        }
+    }
+
+    runTasks(threads, faces, [&](Worker& worker, const ScanTask& task) {
+        const cv::Mat tile_image = gray(task.roi);
+        for (double scale : scales) {
+            if (std::min(task.roi.width, task.roi.height) * scale < FaceDetection::kWindowSize) {
+                break;  // scales are descending, every further level is smaller still
+            }
+            const cv::Mat* level = &tile_image;
+            if (scale != 1.0) {
+                resizeLevel(tile_image, scale, worker.level);
+                level = &worker.level;
+            }
+            dlib::cv_image<unsigned char> dlib_image(*level);
+            worker.detector(dlib_image, worker.scratch, config_.threshold);
+            appendDetections(worker.scratch, cv::Point(), scale, worker.faces);
+            for (size_t k = worker.faces.size() - worker.scratch.size(); k < worker.faces.size(); ++k) {
+                worker.faces[k].rect.x += task.roi.x;
+                worker.faces[k].rect.y += task.roi.y;
+            }
+        }
+    });
+    // Faces inside the overlap of neighbouring tiles are found in both; the caller's NMS merges them
+}
+
+void HogFaceDetector::runTasks(int threads, std::vector<DetectedFace>& faces,
+                               const std::function<void(Worker&, const ScanTask&)>& scan) {
+    threads = std::max(1, std::min(threads, static_cast<int>(tasks_.size())));
+    while (workers_.size() < static_cast<size_t>(threads)) {
+        workers_.push_back({single_level_, {}, {}, {}});
+    }
+
+    std::atomic<size_t> next_task{0};
+    auto run = [&](int index) {
+        Worker& worker = workers_[index];
+        worker.faces.clear();
+        for (size_t t = next_task++; t < tasks_.size(); t = next_task++) {
+            scan(worker, tasks_[t]);
+        }
+    };
+
+    // The pool's threads persist across frames, so a frame does not pay for creating and joining them
+    pool_.run(threads, run);
+
+    for (int w = 0; w < threads; ++w) {
+        faces.insert(faces.end(), workers_[w].faces.begin(), workers_[w].faces.end());
+    }
+}
+
+void HogFaceDetector::resizeLevel(const cv::Mat& image, double scale, cv::Mat& level) {
+    cv::resize(image, level, cv::Size(), scale, scale, scale < 1.0 ? cv::INTER_AREA : cv::INTER_LINEAR);
+}
+
+void HogFaceDetector::appendDetections(const std::vector<dlib::rect_detection>& detections, cv::Point offset,
+                                       double scale, std::vector<DetectedFace>& faces) {
+    for (const auto& det : detections) {
+        const int x = static_cast<int>(std::lround((det.rect.left() + offset.x) / scale));
+        const int y = static_cast<int>(std::lround((det.rect.top() + offset.y) / scale));
+        const int w = static_cast<int>(std::lround(det.rect.width() / scale));
+        const int h = static_cast<int>(std::lround(det.rect.height() / scale));
+        faces.push_back({cv::Rect(x, y, w, h), det.detection_confidence});
+    }
+}
+
+#endif
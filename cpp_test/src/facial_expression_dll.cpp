@@ -1,5 +1,6 @@
 #include "facial_expression_dll.h"
 #include "emotion_analyzer.h"
+#include "image_decode.h"
 #include <opencv2/opencv.hpp>
 #include <memory>
 #include <string>
@@ -8,6 +9,12 @@
 // 全局变量
 static std::unique_ptr<EmotionAnalyzer> g_analyzer = nullptr;
 static std::string g_last_error;
+static AnalysisWorkspace g_workspace;  // 紧凑接口复用的工作区，随分析器一起重建
+static DetectorConfig g_detector_config;  // 跨初始化保留的人脸检测配置
+static ErtBudget g_landmark_budget;       // 跨初始化保留的关键点预算
+static LandmarkTracking g_landmark_tracking;  // 跨初始化保留的关键点跟踪配置
+static OnnxSessionConfig g_onnx_session_config;  // 跨初始化保留的ONNX图优化与缓存配置
+static int g_decode_max_side = ImageDecode::kDefaultTargetMaxSide;  // 编码图像的降分辨率解码目标长边
 
 // 辅助函数：复制字符串到固定长度缓冲区
 void safe_strcpy(char* dest, const char* src, size_t dest_size) {
@@ -24,6 +31,69 @@ void set_error(const std::string& error) {
     g_last_error = error;
 }
 
+// 辅助函数：从原始像素或编码数据（JPEG, PNG）创建Mat
+static cv::Mat decode_image_bytes(const unsigned char* image_data, int data_length,
+                                  int width, int height, int channels) {
+    if (width > 0 && height > 0 && channels > 0) {
+        // 原始像素数据: 1通道灰度、3通道BGR或4通道BGRA；分析在调用内同步完成，直接引用调用方内存
+        if (channels != 1 && channels != 3 && channels != 4) {
+            return cv::Mat();
+        }
+        if (static_cast<long long>(width) * height * channels > data_length) {
+            return cv::Mat();
+        }
+        int cv_type = (channels == 1) ? CV_8UC1 : (channels == 3) ? CV_8UC3 : CV_8UC4;
+        return cv::Mat(height, width, cv_type, const_cast<unsigned char*>(image_data));
+    }
+    
+    // 从编码的图像数据创建Mat，大图按目标长边降分辨率解码
+    return ImageDecode::decodeBytes(image_data, static_cast<size_t>(data_length), g_decode_max_side).image;
+}
+
+// 辅助函数：将YUV帧的Y平面包装为单通道Mat（不拷贝），参数无效时返回空Mat并设置错误
+static cv::Mat wrap_luma_plane(const YUVFrameDLL* frame) {
+    if (!frame) {
+        set_error("Frame is null");
+        return cv::Mat();
+    }
+    if (frame->format != FRAME_FORMAT_NV12 && frame->format != FRAME_FORMAT_I420) {
+        set_error("Unsupported frame format: " + std::to_string(frame->format));
+        return cv::Mat();
+    }
+    if (!frame->planes[0] || frame->width <= 0 || frame->height <= 0 || frame->strides[0] < frame->width) {
+        set_error("Invalid luma plane");
+        return cv::Mat();
+    }
+    
+    // The Y plane of NV12 and I420 is plain 8-bit intensity
+    return cv::Mat(frame->height, frame->width, CV_8UC1,
+                   const_cast<unsigned char*>(frame->planes[0]), static_cast<size_t>(frame->strides[0]));
+}
+
+// 辅助函数：用工作区分析图像并填充紧凑结果
+static void analyze_compact(const cv::Mat& image, EmotionResultCompactDLL& result) {
+    static EmotionResult emotion_result;
+    emotion_result.arousal = 0.0f;
+    emotion_result.valence = 0.0f;
+    emotion_result.intensity = 0.0f;
+    emotion_result.code = {EmotionLabels::kLabelNeutral, -1};
+
+    if (!g_analyzer->analyzeEmotion(image, g_workspace, emotion_result) && !g_workspace.prepared) {
+        set_error("Failed to prepare analysis workspace");
+        result.success = 0;
+        return;
+    }
+    
+    // 未检测到人脸时与完整接口一致，返回Neutral
+    result.arousal = emotion_result.arousal;
+    result.valence = emotion_result.valence;
+    result.intensity = emotion_result.intensity;
+    result.label_id = emotion_result.code.quadrant_label_id;
+    result.intensity_level = emotion_result.code.intensity_level;
+    result.success = 1;
+    set_error("");
+}
+
 // 初始化情绪分析器
 FACIAL_EXPRESSION_API int InitializeEmotionAnalyzer(
     const char* onnx_model_path,
@@ -36,27 +106,32 @@ FACIAL_EXPRESSION_API int InitializeEmotionAnalyzer(
         std::cout << "  Shape: " << (shape_predictor_path ? shape_predictor_path : "NULL") << std::endl;
         std::cout << "  Front: " << (frontalization_model_path ? frontalization_model_path : "NULL") << std::endl;
         
-        // 释放旧的实例
-        if (g_analyzer) {
-            g_analyzer.reset();
-        }
+        g_workspace = AnalysisWorkspace();
         
+        // 先创建新实例再释放旧实例: 模型文件未变时，新实例直接复用旧实例在注册表中持有的模型
         std::cout << "Creating EmotionAnalyzer instance..." << std::endl;
-        g_analyzer = std::make_unique<EmotionAnalyzer>(
+        auto analyzer = std::make_unique<EmotionAnalyzer>(
             onnx_model_path ? onnx_model_path : "model_emotion_pls30.onnx",
             frontalization_model_path ? frontalization_model_path : "model_frontalization.npy",
             shape_predictor_path ? shape_predictor_path : "shape_predictor_68_face_landmarks.dat"
         );
         
+        analyzer->setDetectorConfig(g_detector_config);
+        analyzer->setLandmarkBudget(g_landmark_budget);
+        analyzer->setLandmarkTracking(g_landmark_tracking);
+        analyzer->setOnnxSessionConfig(g_onnx_session_config);
+        
         std::cout << "EmotionAnalyzer instance created, calling initialize..." << std::endl;
-        if (g_analyzer->initialize()) {
+        const bool initialized = analyzer->initialize();
+        g_analyzer.reset();
+        if (initialized) {
+            g_analyzer = std::move(analyzer);
             set_error("");
             std::cout << "Initialization successful!" << std::endl;
             return 1; // 成功
         } else {
-            set_error("Failed to initialize emotion analyzer");
+            set_error("Failed to initialize emotion analyzer: " + analyzer->getInitializationError());
             std::cout << "Initialization failed!" << std::endl;
-            g_analyzer.reset();
             return 0; // 失败
         }
     } catch (const std::exception& e) {
@@ -90,7 +165,7 @@ FACIAL_EXPRESSION_API EmotionResultDLL AnalyzeEmotionFromFile(const char* image_
     }
     
     try {
-        cv::Mat image = cv::imread(image_path);
+        cv::Mat image = ImageDecode::decodeFile(image_path, g_decode_max_side).image;
         if (image.empty()) {
             safe_strcpy(result.error_message, "Failed to load image", sizeof(result.error_message));
             result.success = 0;
@@ -139,17 +214,7 @@ FACIAL_EXPRESSION_API EmotionResultDLL AnalyzeEmotionFromBytes(
     }
     
     try {
-        cv::Mat image;
-        
-        if (width > 0 && height > 0 && channels > 0) {
-            // 从原始像素数据创建Mat
-            int cv_type = (channels == 1) ? CV_8UC1 : (channels == 3) ? CV_8UC3 : CV_8UC4;
-            image = cv::Mat(height, width, cv_type, (void*)image_data).clone();
-        } else {
-            // 从编码的图像数据（如JPEG, PNG）创建Mat
-            std::vector<unsigned char> buffer(image_data, image_data + data_length);
-            image = cv::imdecode(buffer, cv::IMREAD_COLOR);
-        }
+        cv::Mat image = decode_image_bytes(image_data, data_length, width, height, channels);
         
         if (image.empty()) {
             safe_strcpy(result.error_message, "Failed to decode image data", sizeof(result.error_message));
@@ -176,8 +241,379 @@ FACIAL_EXPRESSION_API EmotionResultDLL AnalyzeEmotionFromBytes(
     return result;
 }
 
+// 紧凑版本：从文件分析情绪
+FACIAL_EXPRESSION_API EmotionResultCompactDLL AnalyzeEmotionFromFileCompact(const char* image_path) {
+    EmotionResultCompactDLL result = { 0 };
+    result.label_id = EmotionLabels::kLabelNeutral;
+    result.intensity_level = -1;
+    
+    if (!g_analyzer) {
+        set_error("Emotion analyzer not initialized");
+        return result;
+    }
+    
+    if (!image_path) {
+        set_error("Image path is null");
+        return result;
+    }
+    
+    try {
+        cv::Mat image = ImageDecode::decodeFile(image_path, g_decode_max_side).image;
+        if (image.empty()) {
+            set_error("Failed to load image");
+            return result;
+        }
+        
+        analyze_compact(image, result);
+        
+    } catch (const std::exception& e) {
+        result.success = 0;
+        set_error("Exception during emotion analysis: " + std::string(e.what()));
+    }
+    
+    return result;
+}
+
+// 紧凑版本：从字节数组分析情绪
+FACIAL_EXPRESSION_API EmotionResultCompactDLL AnalyzeEmotionFromBytesCompact(
+    const unsigned char* image_data,
+    int data_length,
+    int width,
+    int height,
+    int channels
+) {
+    EmotionResultCompactDLL result = { 0 };
+    result.label_id = EmotionLabels::kLabelNeutral;
+    result.intensity_level = -1;
+    
+    if (!g_analyzer) {
+        set_error("Emotion analyzer not initialized");
+        return result;
+    }
+    
+    if (!image_data || data_length <= 0) {
+        set_error("Invalid image data");
+        return result;
+    }
+    
+    try {
+        cv::Mat image = decode_image_bytes(image_data, data_length, width, height, channels);
+        if (image.empty()) {
+            set_error("Failed to decode image data");
+            return result;
+        }
+        
+        analyze_compact(image, result);
+        
+    } catch (const std::exception& e) {
+        result.success = 0;
+        set_error("Exception during emotion analysis: " + std::string(e.what()));
+    }
+    
+    return result;
+}
+
+// 预热分析器
+FACIAL_EXPRESSION_API int WarmupEmotionAnalyzer(int iterations, int width, int height) {
+    if (!g_analyzer) {
+        set_error("Emotion analyzer not initialized");
+        return -1;
+    }
+    
+    try {
+        // 紧凑接口和YUV帧接口复用的工作区一并预热
+        WarmupReport report = g_analyzer->warmup(iterations, cv::Size(width, height), &g_workspace);
+        if (!report.success) {
+            set_error("Warmup failed");
+            return -1;
+        }
+        
+        set_error("");
+        return report.steady_state_iteration > 0 ? report.steady_state_iteration : 0;
+        
+    } catch (const std::exception& e) {
+        set_error("Exception during warmup: " + std::string(e.what()));
+        return -1;
+    }
+}
+
+// 热重载模型
+FACIAL_EXPRESSION_API int ReloadEmotionModels(
+    const char* onnx_model_path,
+    const char* shape_predictor_path,
+    const char* frontalization_model_path
+) {
+    if (!g_analyzer) {
+        set_error("Emotion analyzer not initialized");
+        return 0;
+    }
+    
+    try {
+        // NULL保留当前模型；工作区在下一次分析时按模型代数重新绑定
+        if (!g_analyzer->reloadModels(onnx_model_path ? onnx_model_path : "",
+                                      frontalization_model_path ? frontalization_model_path : "",
+                                      shape_predictor_path ? shape_predictor_path : "")) {
+            set_error("Failed to reload models, the current models are kept");
+            return 0;
+        }
+        set_error("");
+        return 1;
+    } catch (const std::exception& e) {
+        set_error("Exception during model reload: " + std::string(e.what()));
+        return 0;
+    }
+}
+
+// 从YUV帧分析情绪
+FACIAL_EXPRESSION_API EmotionResultDLL AnalyzeEmotionFromYUVFrame(const YUVFrameDLL* frame) {
+    EmotionResultDLL result = { 0 };
+    
+    if (!g_analyzer) {
+        safe_strcpy(result.error_message, "Emotion analyzer not initialized", sizeof(result.error_message));
+        result.success = 0;
+        return result;
+    }
+    
+    try {
+        cv::Mat luma = wrap_luma_plane(frame);
+        if (luma.empty()) {
+            safe_strcpy(result.error_message, g_last_error.c_str(), sizeof(result.error_message));
+            result.success = 0;
+            return result;
+        }
+        
+        // Camera frames share g_workspace with the compact interfaces, so landmark tracking applies here too
+        static EmotionResult emotion_result;
+        emotion_result.arousal = 0.0f;
+        emotion_result.valence = 0.0f;
+        emotion_result.intensity = 0.0f;
+        emotion_result.emotion_name = "neutral";
+        emotion_result.code = {EmotionLabels::kLabelNeutral, -1};
+        if (!g_analyzer->analyzeEmotion(luma, g_workspace, emotion_result) && !g_workspace.prepared) {
+            set_error("Failed to prepare analysis workspace");
+            safe_strcpy(result.error_message, g_last_error.c_str(), sizeof(result.error_message));
+            result.success = 0;
+            return result;
+        }
+        
+        result.arousal = emotion_result.arousal;
+        result.valence = emotion_result.valence;
+        result.intensity = emotion_result.intensity;
+        safe_strcpy(result.emotion_name, emotion_result.emotion_name.c_str(), sizeof(result.emotion_name));
+        result.success = 1;
+        
+        set_error("");
+        
+    } catch (const std::exception& e) {
+        safe_strcpy(result.error_message, e.what(), sizeof(result.error_message));
+        result.success = 0;
+        set_error("Exception during emotion analysis: " + std::string(e.what()));
+    }
+    
+    return result;
+}
+
+// 紧凑版本：从YUV帧分析情绪
+FACIAL_EXPRESSION_API EmotionResultCompactDLL AnalyzeEmotionFromYUVFrameCompact(const YUVFrameDLL* frame) {
+    EmotionResultCompactDLL result = { 0 };
+    result.label_id = EmotionLabels::kLabelNeutral;
+    result.intensity_level = -1;
+    
+    if (!g_analyzer) {
+        set_error("Emotion analyzer not initialized");
+        return result;
+    }
+    
+    try {
+        cv::Mat luma = wrap_luma_plane(frame);
+        if (luma.empty()) {
+            return result;
+        }
+        
+        analyze_compact(luma, result);
+        
+    } catch (const std::exception& e) {
+        result.success = 0;
+        set_error("Exception during emotion analysis: " + std::string(e.what()));
+    }
+    
+    return result;
+}
+
+// 在给定人脸框上分析情绪
+FACIAL_EXPRESSION_API int AnalyzeEmotionInRects(
+    const unsigned char* image_data,
+    int data_length,
+    int width,
+    int height,
+    int channels,
+    const FaceRectDLL* rects,
+    int num_rects,
+    EmotionResultCompactDLL* results
+) {
+    if (!g_analyzer) {
+        set_error("Emotion analyzer not initialized");
+        return -1;
+    }
+    
+    if (!image_data || data_length <= 0) {
+        set_error("Invalid image data");
+        return -1;
+    }
+    
+    if (num_rects < 0 || (num_rects > 0 && (!rects || !results))) {
+        set_error("Invalid face rectangles");
+        return -1;
+    }
+    
+    try {
+        // Boxes are in original-image coordinates; encoded input may be decoded at reduced size
+        cv::Mat image;
+        double scale_x = 1.0, scale_y = 1.0;
+        if (width > 0 && height > 0 && channels > 0) {
+            image = decode_image_bytes(image_data, data_length, width, height, channels);
+        } else {
+            ImageDecode::DecodedImage decoded =
+                ImageDecode::decodeBytes(image_data, static_cast<size_t>(data_length), g_decode_max_side);
+            image = decoded.image;
+            if (!image.empty()) {
+                scale_x = static_cast<double>(image.cols) / decoded.original_size.width;
+                scale_y = static_cast<double>(image.rows) / decoded.original_size.height;
+            }
+        }
+        if (image.empty()) {
+            set_error("Failed to decode image data");
+            return -1;
+        }
+        
+        std::vector<cv::Rect> face_rects;
+        face_rects.reserve(num_rects);
+        for (int i = 0; i < num_rects; ++i) {
+            face_rects.emplace_back(cvRound(rects[i].x * scale_x), cvRound(rects[i].y * scale_y),
+                                    cvRound(rects[i].width * scale_x), cvRound(rects[i].height * scale_y));
+        }
+        
+        std::vector<FaceEmotion> faces = g_analyzer->analyzeFacesInRects(image, face_rects);
+        
+        int analyzed = 0;
+        for (int i = 0; i < num_rects; ++i) {
+            const FaceEmotion& face = faces[i];
+            results[i].arousal = face.emotion.arousal;
+            results[i].valence = face.emotion.valence;
+            results[i].intensity = face.emotion.intensity;
+            results[i].label_id = face.emotion.code.quadrant_label_id;
+            results[i].intensity_level = face.emotion.code.intensity_level;
+            results[i].success = face.success ? 1 : 0;
+            analyzed += face.success ? 1 : 0;
+        }
+        
+        set_error("");
+        return analyzed;
+        
+    } catch (const std::exception& e) {
+        set_error("Exception during emotion analysis: " + std::string(e.what()));
+        return -1;
+    }
+}
+
+// 设置人脸检测配置
+FACIAL_EXPRESSION_API int SetDetectorConfig(const DetectorConfigDLL* config) {
+    if (!config) {
+        set_error("Detector config is null");
+        return 0;
+    }
+    
+    DetectorConfig detector_config;
+    detector_config.min_face_size = config->min_face_size;
+    detector_config.max_face_size = config->max_face_size;
+    if (config->pyramid_ratio != 0.0) {
+        detector_config.pyramid_ratio = config->pyramid_ratio;
+    }
+    detector_config.threshold = config->threshold;
+    detector_config.upsample = config->upsample;
+    detector_config.ladder = config->ladder != 0;
+    detector_config.threads = config->threads;
+    detector_config.tile_size = config->tile_size;
+    if (config->tile_overlap != 0) {
+        detector_config.tile_overlap = config->tile_overlap;
+    }
+    if (config->backend && config->backend[0] != '\0' &&
+        !FaceDetection::parseBackend(config->backend, detector_config)) {
+        set_error("Unknown detector backend");
+        return 0;
+    }
+    
+    if (detector_config.min_face_size < 0 || detector_config.max_face_size < 0 || detector_config.upsample < 0 ||
+        detector_config.threads < 0 || detector_config.tile_size < 0 || detector_config.tile_overlap < 0 ||
+        detector_config.pyramid_ratio <= 0.0 || detector_config.pyramid_ratio >= 1.0) {
+        set_error("Invalid detector config");
+        return 0;
+    }
+    
+    g_detector_config = detector_config;
+    if (g_analyzer) {
+        g_analyzer->setDetectorConfig(detector_config);
+    }
+    set_error("");
+    return 1;
+}
+
+// 设置关键点快速模式的级联/树预算
+FACIAL_EXPRESSION_API int SetLandmarkBudget(int cascades, int trees) {
+    if (cascades < 0 || trees < 0) {
+        set_error("Invalid landmark budget");
+        return 0;
+    }
+    
+    g_landmark_budget.cascades = cascades;
+    g_landmark_budget.trees = trees;
+    if (g_analyzer) {
+        g_analyzer->setLandmarkBudget(g_landmark_budget);
+    }
+    set_error("");
+    return 1;
+}
+
+// 开关视频关键点跟踪；切换时清空紧凑接口工作区的跟踪状态
+FACIAL_EXPRESSION_API void SetLandmarkTracking(int enabled) {
+    g_landmark_tracking.enabled = enabled != 0;
+    g_workspace.previous_landmarks.clear();
+    g_workspace.tracked_frames = 0;
+    if (g_analyzer) {
+        g_analyzer->setLandmarkTracking(g_landmark_tracking);
+    }
+}
+
+// 设置ONNX图优化级别与优化模型缓存目录
+FACIAL_EXPRESSION_API int SetOnnxSessionOptions(int optimization_level, const char* cache_dir) {
+    if (optimization_level < 0 || optimization_level > 3) {
+        set_error("Invalid ONNX optimization level");
+        return 0;
+    }
+    
+    g_onnx_session_config.optimization_level = optimization_level;
+    g_onnx_session_config.cache = cache_dir == nullptr || cache_dir[0] != '\0';
+    g_onnx_session_config.cache_dir = cache_dir ? cache_dir : "";
+    if (g_analyzer) {
+        g_analyzer->setOnnxSessionConfig(g_onnx_session_config);
+    }
+    set_error("");
+    return 1;
+}
+
+// 设置降分辨率解码的目标长边
+FACIAL_EXPRESSION_API void SetDecodeMaxSide(int max_side) {
+    g_decode_max_side = max_side > 0 ? max_side : 0;
+}
+
+// 获取标签编码对应的完整标签
+FACIAL_EXPRESSION_API const char* GetEmotionLabel(int label_id, int intensity_level) {
+    return EmotionLabels::label({label_id, intensity_level});
+}
+
 // 释放资源
 FACIAL_EXPRESSION_API void ReleaseEmotionAnalyzer() {
+    g_workspace = AnalysisWorkspace();
     g_analyzer.reset();
     set_error("");
 }
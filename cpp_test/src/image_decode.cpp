@@ -0,0 +1,176 @@
+#include "image_decode.h"
+#include <fstream>
+#include <iostream>
+#include <algorithm>
+#include <cstdint>
+
+namespace ImageDecode {
+
+namespace {
+
+uint32_t readBigEndian16(const unsigned char* p) {
+    return (static_cast<uint32_t>(p[0]) << 8) | p[1];
+}
+
+uint32_t readBigEndian32(const unsigned char* p) {
+    return (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16) |
+           (static_cast<uint32_t>(p[2]) << 8) | p[3];
+}
+
+// Walk JPEG marker segments up to the first SOFn frame header
+bool readJpegSize(const unsigned char* data, size_t length, cv::Size& size) {
+    size_t pos = 2;  // past SOI
+    while (pos + 4 <= length) {
+        if (data[pos] != 0xFF) {
+            return false;
+        }
+        const unsigned char marker = data[pos + 1];
+        if (marker == 0xFF) {
+            ++pos;  // fill byte
+            continue;
+        }
+        pos += 2;
+
+        // Standalone markers carry no length field
+        if (marker == 0x01 || (marker >= 0xD0 && marker <= 0xD8)) {
+            continue;
+        }
+        if (marker == 0xD9 || marker == 0xDA) {
+            return false;  // EOI or SOS before any frame header
+        }
+
+        const uint32_t segment_length = readBigEndian16(data + pos);
+        if (segment_length < 2 || pos + segment_length > length) {
+            return false;
+        }
+
+        // SOF0-SOF15 except DHT (C4), JPG (C8) and DAC (CC)
+        const bool is_frame = marker >= 0xC0 && marker <= 0xCF &&
+                              marker != 0xC4 && marker != 0xC8 && marker != 0xCC;
+        if (is_frame) {
+            if (segment_length < 7) {
+                return false;
+            }
+            const int height = static_cast<int>(readBigEndian16(data + pos + 3));
+            const int width = static_cast<int>(readBigEndian16(data + pos + 5));
+            size = cv::Size(width, height);
+            return width > 0 && height > 0;
+        }
+
+        pos += segment_length;
+    }
+    return false;
+}
+
+int reducedFlag(int reduction) {
+    switch (reduction) {
+        case 2: return cv::IMREAD_REDUCED_COLOR_2;
+        case 4: return cv::IMREAD_REDUCED_COLOR_4;
+        case 8: return cv::IMREAD_REDUCED_COLOR_8;
+        default: return cv::IMREAD_COLOR;
+    }
+}
+
+} // namespace
+
+bool readImageSize(const unsigned char* data, size_t length, cv::Size& size) {
+    if (data == nullptr) {
+        return false;
+    }
+
+    if (length >= 4 && data[0] == 0xFF && data[1] == 0xD8) {
+        return readJpegSize(data, length, size);
+    }
+
+    // PNG: 8-byte signature, then IHDR with big-endian width/height
+    static const unsigned char kPngSignature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    if (length >= 24 && std::equal(kPngSignature, kPngSignature + 8, data) &&
+        std::equal(data + 12, data + 16, "IHDR")) {
+        const int width = static_cast<int>(readBigEndian32(data + 16));
+        const int height = static_cast<int>(readBigEndian32(data + 20));
+        size = cv::Size(width, height);
+        return width > 0 && height > 0;
+    }
+
+    return false;
+}
+
+int chooseReduction(cv::Size original_size, int target_max_side) {
+    if (target_max_side <= 0) {
+        return 1;
+    }
+    const int max_side = std::max(original_size.width, original_size.height);
+    for (int reduction : {8, 4, 2}) {
+        if (max_side / reduction >= target_max_side) {
+            return reduction;
+        }
+    }
+    return 1;
+}
+
+DecodedImage decodeBytes(const unsigned char* data, size_t length, int target_max_side) {
+    DecodedImage decoded;
+    if (data == nullptr || length == 0) {
+        return decoded;
+    }
+
+    cv::Size header_size;
+    const bool has_size = readImageSize(data, length, header_size);
+    decoded.reduction = has_size ? chooseReduction(header_size, target_max_side) : 1;
+
+    // cv::Mat header over the caller's bytes, no copy
+    cv::Mat buffer(1, static_cast<int>(length), CV_8UC1, const_cast<unsigned char*>(data));
+    decoded.image = cv::imdecode(buffer, reducedFlag(decoded.reduction));
+    if (decoded.image.empty()) {
+        return decoded;
+    }
+
+    if (!has_size) {
+        decoded.original_size = decoded.image.size();
+        return decoded;
+    }
+
+    // EXIF orientation may rotate the decoded image by 90 degrees relative to the header
+    const bool header_landscape = header_size.width >= header_size.height;
+    const bool image_landscape = decoded.image.cols >= decoded.image.rows;
+    if (header_size.width != header_size.height && header_landscape != image_landscape) {
+        std::swap(header_size.width, header_size.height);
+    }
+    decoded.original_size = header_size;
+    return decoded;
+}
+
+DecodedImage decodeFile(const std::string& path, int target_max_side) {
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file.is_open()) {
+        return DecodedImage();
+    }
+
+    const std::streamsize length = file.tellg();
+    if (length <= 0) {
+        return DecodedImage();
+    }
+    std::vector<unsigned char> bytes(static_cast<size_t>(length));
+    file.seekg(0);
+    if (!file.read(reinterpret_cast<char*>(bytes.data()), length)) {
+        std::cerr << "Failed to read image file: " << path << std::endl;
+        return DecodedImage();
+    }
+
+    return decodeBytes(bytes.data(), bytes.size(), target_max_side);
+}
+
+void mapToOriginal(std::vector<cv::Point2f>& points, const DecodedImage& decoded) {
+    if (decoded.image.empty() || decoded.reduction == 1) {
+        return;
+    }
+    // libjpeg rounds reduced dimensions up, so use the exact ratio rather than the factor
+    const float scale_x = static_cast<float>(decoded.original_size.width) / decoded.image.cols;
+    const float scale_y = static_cast<float>(decoded.original_size.height) / decoded.image.rows;
+    for (auto& point : points) {
+        point.x *= scale_x;
+        point.y *= scale_y;
+    }
+}
+
+}
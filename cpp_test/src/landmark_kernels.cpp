@@ -0,0 +1,264 @@
+#include "landmark_kernels.h"
+#include <algorithm>
+#include <cmath>
+
+#ifdef OPENBLAS_AVAILABLE
+#include <cblas.h>
+#endif
+
+namespace LandmarkKernels {
+
+namespace {
+
+// 4x8寄存器分块微内核: 累加器常驻寄存器，沿K方向依次读取打包后的A/B面板
+// a: [k][MR]，b: [k][NR]，只写回有效的rows x cols部分
+inline void microKernel(int k, const float* a, const float* b,
+                        float* c, int ldc, int rows, int cols) {
+    float acc[kMicroRows][kMicroCols] = {};
+
+    for (int kk = 0; kk < k; ++kk) {
+        const float* ak = a + kk * kMicroRows;
+        const float* bk = b + kk * kMicroCols;
+        for (int r = 0; r < kMicroRows; ++r) {
+            const float av = ak[r];
+            for (int j = 0; j < kMicroCols; ++j) {
+                acc[r][j] += av * bk[j];
+            }
+        }
+    }
+
+    for (int r = 0; r < rows; ++r) {
+        for (int j = 0; j < cols; ++j) {
+            c[r * ldc + j] = acc[r][j];
+        }
+    }
+}
+
+// 将A的一个MC行块打包成MR行的微面板: packed[panel][k][0..MR)，不足MR的行补零
+void packRowBlock(int rows, int k, const float* a, int lda, float* packed) {
+    const int micro_panels = (rows + kMicroRows - 1) / kMicroRows;
+    for (int mp = 0; mp < micro_panels; ++mp) {
+        float* dst = packed + mp * k * kMicroRows;
+        for (int kk = 0; kk < k; ++kk) {
+            for (int r = 0; r < kMicroRows; ++r) {
+                const int row = mp * kMicroRows + r;
+                dst[kk * kMicroRows + r] = (row < rows) ? a[row * lda + kk] : 0.0f;
+            }
+        }
+    }
+}
+
+} // namespace
+
+std::vector<float> packWeightPanels(const float* weights, int k, int n) {
+    const int panels = (n + kMicroCols - 1) / kMicroCols;
+    std::vector<float> packed(static_cast<size_t>(panels) * k * kMicroCols, 0.0f);
+
+    for (int p = 0; p < panels; ++p) {
+        float* dst = packed.data() + static_cast<size_t>(p) * k * kMicroCols;
+        for (int kk = 0; kk < k; ++kk) {
+            for (int j = 0; j < kMicroCols; ++j) {
+                const int col = p * kMicroCols + j;
+                if (col < n) {
+                    dst[kk * kMicroCols + j] = weights[kk * n + col];
+                }
+            }
+        }
+    }
+
+    return packed;
+}
+
+void gemmPacked(int m, int n, int k,
+                const float* a, int lda,
+                const float* b_packed,
+                float* c, int ldc) {
+    if (m <= 0 || n <= 0 || k <= 0) {
+        return;
+    }
+
+    // A块的打包缓冲区按线程复用，稳态下不再分配
+    thread_local std::vector<float> a_packed;
+    const size_t block_size = static_cast<size_t>(kBlockRows) * k;
+    if (a_packed.size() < block_size) {
+        a_packed.resize(block_size);
+    }
+
+    const int panels = (n + kMicroCols - 1) / kMicroCols;
+
+    for (int m0 = 0; m0 < m; m0 += kBlockRows) {
+        const int mc = std::min(kBlockRows, m - m0);
+        const int micro_panels = (mc + kMicroRows - 1) / kMicroRows;
+        packRowBlock(mc, k, a + m0 * lda, lda, a_packed.data());
+
+        // 权重面板在外层循环: 一个面板(约4KB)留在L1中，A块从L2流过
+        for (int p = 0; p < panels; ++p) {
+            const float* bp = b_packed + static_cast<size_t>(p) * k * kMicroCols;
+            const int cols = std::min(kMicroCols, n - p * kMicroCols);
+
+            for (int mp = 0; mp < micro_panels; ++mp) {
+                const int rows = std::min(kMicroRows, mc - mp * kMicroRows);
+                microKernel(k, a_packed.data() + static_cast<size_t>(mp) * k * kMicroRows, bp,
+                            c + (m0 + mp * kMicroRows) * ldc + p * kMicroCols, ldc,
+                            rows, cols);
+            }
+        }
+    }
+}
+
+void gemm(int m, int n, int k,
+          const float* a, int lda,
+          const float* b, int ldb,
+          float* c, int ldc) {
+    if (m <= 0 || n <= 0 || k <= 0) {
+        return;
+    }
+
+#ifdef OPENBLAS_AVAILABLE
+    cblas_sgemm(CblasRowMajor, CblasNoTrans, CblasNoTrans,
+                m, n, k, 1.0f, a, lda, b, ldb, 0.0f, c, ldc);
+#else
+    // 没有BLAS时先打包再走分块内核
+    std::vector<float> dense(static_cast<size_t>(k) * n);
+    for (int kk = 0; kk < k; ++kk) {
+        std::copy(b + kk * ldb, b + kk * ldb + n, dense.begin() + static_cast<size_t>(kk) * n);
+    }
+    std::vector<float> packed = packWeightPanels(dense.data(), k, n);
+    gemmPacked(m, n, k, a, lda, packed.data(), c, ldc);
+#endif
+}
+
+void standardizeToFeatureRow(const float* landmarks_xy, float* row) {
+    float* xs = row;
+    float* ys = row + kNumLandmarks;
+
+    // Translation - center the landmarks
+    float mean_x = 0.0f, mean_y = 0.0f;
+    for (int i = 0; i < kNumLandmarks; ++i) {
+        mean_x += landmarks_xy[2 * i];
+        mean_y += landmarks_xy[2 * i + 1];
+    }
+    mean_x /= kNumLandmarks;
+    mean_y /= kNumLandmarks;
+
+    float sum_squared_distances = 0.0f;
+    for (int i = 0; i < kNumLandmarks; ++i) {
+        xs[i] = landmarks_xy[2 * i] - mean_x;
+        ys[i] = landmarks_xy[2 * i + 1] - mean_y;
+        sum_squared_distances += (xs[i] * xs[i] + ys[i] * ys[i]);
+    }
+
+    // Scale - normalize by RMS distance from origin
+    const float scale = std::sqrt(sum_squared_distances / kNumLandmarks);
+    if (scale > 0) {
+        for (int i = 0; i < kNumLandmarks; ++i) {
+            xs[i] /= scale;
+            ys[i] /= scale;
+        }
+    }
+
+    // Rotation - align the eye centers (36-41, 42-47) horizontally
+    float left_x = 0.0f, left_y = 0.0f, right_x = 0.0f, right_y = 0.0f;
+    for (int i = 36; i < 42; ++i) {
+        left_x += xs[i];
+        left_y += ys[i];
+    }
+    for (int i = 42; i < 48; ++i) {
+        right_x += xs[i];
+        right_y += ys[i];
+    }
+    const float dx = right_x / 6 - left_x / 6;
+    const float dy = right_y / 6 - left_y / 6;
+
+    if (dx != 0) {
+        // a = atan(dy / dx) lies in (-pi/2, pi/2), so cos(a) = |dx| / r and
+        // sin(a) = sign(dx) * dy / r with r = |(dx, dy)|
+        const float r = std::sqrt(dx * dx + dy * dy);
+        const float cos_a = std::fabs(dx) / r;
+        const float sin_a = (dx > 0 ? dy : -dy) / r;
+
+        for (int i = 0; i < kNumLandmarks; ++i) {
+            const float x = xs[i];
+            const float y = ys[i];
+            xs[i] = x * cos_a + y * sin_a;
+            ys[i] = -x * sin_a + y * cos_a;
+        }
+    }
+
+    // Intercept term
+    row[2 * kNumLandmarks] = 1.0f;
+}
+
+void frontalizeRow(const float* row, const float* weights, float* frontal) {
+    // Same per-output summation order as the GEMV in frontalizeLandmarks, but
+    // walking the weights row by row so every load is unit-stride
+    for (int i = 0; i < kFrontalOutputDim; ++i) {
+        frontal[i] = 0.0f;
+    }
+    for (int j = 0; j < kFrontalInputDim; ++j) {
+        const float v = row[j];
+        const float* w = weights + j * kFrontalOutputDim;
+        for (int i = 0; i < kFrontalOutputDim; ++i) {
+            frontal[i] += v * w[i];
+        }
+    }
+}
+
+int pairwiseDistanceFeatures(const float* frontal, bool full_features, float* features) {
+    const float* xs = frontal;
+    const float* ys = frontal + kNumLandmarks;
+
+    // Python's full_features=False uses landmarks 0-50 for the distances
+    // and 17-67 for the scale; full_features=True uses 0-67 for both
+    const int feature_end = full_features ? kNumLandmarks : 51;
+    const int scale_begin = full_features ? 0 : 17;
+    const int scale_count = kNumLandmarks - scale_begin;
+
+    float mean_x = 0.0f, mean_y = 0.0f;
+    for (int i = scale_begin; i < kNumLandmarks; ++i) {
+        mean_x += xs[i];
+        mean_y += ys[i];
+    }
+    mean_x /= scale_count;
+    mean_y /= scale_count;
+
+    float sum_squared_distances = 0.0f;
+    for (int i = scale_begin; i < kNumLandmarks; ++i) {
+        const float dx = xs[i] - mean_x;
+        const float dy = ys[i] - mean_y;
+        sum_squared_distances += (dx * dx + dy * dy);
+    }
+    const float scale = std::sqrt(sum_squared_distances / scale_count);
+
+    int count = 0;
+    for (int i = 0; i < feature_end; ++i) {
+        for (int j = i + 1; j < feature_end; ++j) {
+            const float dx = xs[i] - xs[j];
+            const float dy = ys[i] - ys[j];
+            features[count++] = std::sqrt(dx * dx + dy * dy) / scale;
+        }
+    }
+
+    return count;
+}
+
+int computeModelFeatures(const float* landmarks_xy, const float* weights,
+                         bool full_features, float* features) {
+    // ~1KB of scratch, stays in L1 for the whole pipeline
+    float row[kFrontalInputDim];
+    float frontal[kFrontalOutputDim];
+
+    standardizeToFeatureRow(landmarks_xy, row);
+    frontalizeRow(row, weights, frontal);
+    return pairwiseDistanceFeatures(frontal, full_features, features);
+}
+
+bool blasAvailable() {
+#ifdef OPENBLAS_AVAILABLE
+    return true;
+#else
+    return false;
+#endif
+}
+
+} // namespace LandmarkKernels
@@ -1,10 +1,15 @@
 #include "emotion_analyzer.h"
 #include "model_comparison.h"
+#include "benchmark.h"
+#include "image_decode.h"
 #include "utils.h"
 #include <iostream>
 #include <string>
 #include <vector>
 #include <memory>
+#include <algorithm>
+#include <cstdlib>
+#include <cstdio>
 #include <opencv2/opencv.hpp>
 
 void showHelp(const char* program_name) {
@@ -13,22 +18,80 @@ void showHelp(const char* program_name) {
     std::cout << "  -h, --help              Show help information\n";
     std::cout << "  -i, --image <path>      Analyze single image\n";
     std::cout << "  -b, --batch <dir>       Batch analyze images in directory\n";
-    std::cout << "  -c, --compare           Compare with Python model\n";
+    std::cout << "  -c, --compare           Compare with Python reference outputs (golden fixtures)\n";
+    std::cout << "  -g, --golden <path>     Run golden parity test with the given fixture file\n";
+    std::cout << "  --data-dir <path>       Data directory (default: ../data)\n";
+    std::cout << "  --benchmark             Run end-to-end throughput/latency benchmark\n";
+    std::cout << "  --baseline <file>       Compare benchmark against a JSON baseline\n";
+    std::cout << "  --save-baseline <file>  Write benchmark result as a JSON baseline\n";
+    std::cout << "  --threshold <ratio>     Allowed regression vs baseline (default: 0.10)\n";
+    std::cout << "  --bench-iterations <n>  Timed passes over the corpus (default: 5)\n";
+    std::cout << "  --detector-sweep        Compare detector settings (speed vs recall) on the data set\n";
+    std::cout << "  --detector <name>       Face detector backend: hog, haar, lbp or a cascade .xml file\n";
+    std::cout << "  --landmark-compare      Compare the native ERT evaluator with dlib's shape predictor (speed and accuracy)\n";
+    std::cout << "  --landmark-cascades <k> Run only the first k landmark cascades (fast mode, default: all)\n";
+    std::cout << "  --landmark-trees <n>    Run only the first n trees of each landmark cascade (default: all)\n";
+    std::cout << "  --landmark-report       Report landmark RMSE and arousal/valence deviation of truncated cascades\n";
+    std::cout << "  --track-landmarks       Warm-start landmarks from the previous frame in video/workspace analysis\n";
+    std::cout << "  --tracking-report       Compare full and warm-started landmarks on simulated camera motion\n";
+    std::cout << "  --shared-models <n>     Create n analyzers on the same model files and report load time and memory\n";
+    std::cout << "  --export-flat-landmarks <file>  Convert the shape predictor to a flat file that worker processes map and share\n";
+    std::cout << "  --hot-reload-report     Reload the ONNX model repeatedly during analysis and report latency and result drift\n";
+    std::cout << "  --ort-opt <level>       ONNX graph optimization: 0 off, 1 basic, 2 extended, 3 all (default: 2)\n";
+    std::cout << "  --ort-cache-dir <dir>   Directory for optimized ONNX models (default: per-user cache, e.g. ~/.cache/emotion_ort_cache)\n";
+    std::cout << "  --no-ort-cache          Optimize the ONNX model on every start instead of caching it\n";
+    std::cout << "  --ort-cache-report      Report ONNX session creation time with and without the optimized model cache\n";
+    std::cout << "  --dlib-landmarks        Use dlib's shape predictor instead of the native ERT evaluator\n";
+    std::cout << "  --min-face <px>         Smallest face to detect (default: 80, or 40 with --upsample 1)\n";
+    std::cout << "  --max-face <px>         Largest face to detect (default: unlimited)\n";
+    std::cout << "  --pyramid-ratio <r>     Scale between detector pyramid levels (default: 0.833)\n";
+    std::cout << "  --det-threshold <t>     Detection threshold offset, higher is stricter (default: 0)\n";
+    std::cout << "  --upsample <n>          Upsample the image n times before detection (default: 0)\n";
+    std::cout << "  --det-threads <n>       HOG detection threads for images >= 640x480 (default: 0 = all cores)\n";
+    std::cout << "  --tile <px>             Detect in overlapping tiles of this size for very large images (default: off)\n";
+    std::cout << "  --tile-overlap <px>     Overlap between detection tiles (default: 256)\n";
+    std::cout << "  --ladder [sizes]        Two-pass detection ladder, e.g. 160,80,40 (default): retry smaller faces only on miss\n";
+    std::cout << "  --decode-max-side <n>   Decode large images at reduced resolution down to this long side (0 = full, default: 1280)\n";
+    std::cout << "  --warmup <n>            Run n warmup iterations before analysis\n";
+    std::cout << "  --warmup-size <WxH>     Frame size used for warmup (default: 640x480)\n";
     std::cout << "  -v, --verbose           Verbose output\n";
     std::cout << "  --model-path <path>     Path to ONNX model\n";
     std::cout << "  --shape-predictor <path> Path to shape predictor\n";
     std::cout << "  --frontalization <path> Path to frontalization model\n";
 }
 
-void analyzeImage(const std::string& image_path, EmotionAnalyzer& analyzer) {
-    cv::Mat image = cv::imread(image_path);
-    if (image.empty()) {
+void analyzeImage(const std::string& image_path, EmotionAnalyzer& analyzer, int decode_max_side) {
+    ImageDecode::DecodedImage decoded = ImageDecode::decodeFile(image_path, decode_max_side);
+    if (decoded.image.empty()) {
         std::cerr << "Error: Cannot load image " << image_path << std::endl;
         return;
     }
     
     std::cout << "Analyzing image: " << image_path << std::endl;
-      auto result = analyzer.analyzeEmotion(image);
+    if (decoded.reduction > 1) {
+        std::cout << "Decoded at 1/" << decoded.reduction << " resolution ("
+                  << decoded.original_size.width << "x" << decoded.original_size.height << " -> "
+                  << decoded.image.cols << "x" << decoded.image.rows << ")" << std::endl;
+    }
+    
+    LandmarksData landmarks_data;
+    auto result = analyzer.analyzeEmotion(decoded.image, landmarks_data);
+    
+    DetectorStats stats = analyzer.getDetectorStats();
+    if (stats.calls > 0) {
+        std::cout << "Face detection (" << analyzer.getDetectorName() << "): " << stats.last_ms << " ms" << std::endl;
+    }
+    if (analyzer.getDetectorConfig().ladder && landmarks_data.detection_rung >= 0) {
+        std::cout << "Detection ladder rung: " << landmarks_data.detection_rung << " (min face "
+                  << analyzer.getDetectorConfig().ladder_min_faces[landmarks_data.detection_rung] << "px)" << std::endl;
+    }
+    
+    if (!landmarks_data.raw_landmarks.empty()) {
+        ImageDecode::mapToOriginal(landmarks_data.raw_landmarks, decoded);
+        cv::Rect face = cv::boundingRect(landmarks_data.raw_landmarks);
+        std::cout << "Face landmarks bounding box: " << face.x << "," << face.y << " "
+                  << face.width << "x" << face.height << std::endl;
+    }
     
     std::cout << "Predicted emotion: " << result.emotion_name << std::endl;
     std::cout << "Arousal: " << result.arousal << std::endl;
@@ -50,9 +113,9 @@ std::vector<std::string> getImageFiles(const std::string& directory_path) {
         directory_path + "/example.png"
     };
     
+    // Existence check only; decoding happens once in analyzeImage
     for (const auto& file : test_files) {
-        cv::Mat test_img = cv::imread(file);
-        if (!test_img.empty()) {
+        if (Utils::fileExists(file)) {
             image_files.push_back(file);
         }
     }
@@ -60,64 +123,169 @@ std::vector<std::string> getImageFiles(const std::string& directory_path) {
     return image_files;
 }
 
-void batchAnalyze(const std::string& directory_path, EmotionAnalyzer& analyzer) {
+void batchAnalyze(const std::string& directory_path, EmotionAnalyzer& analyzer, int decode_max_side) {
     std::cout << "Batch analyzing images in: " << directory_path << std::endl;
     
     // Implementation would scan directory and analyze each image
     std::vector<std::string> image_files = getImageFiles(directory_path);
     
     for (const auto& file : image_files) {
-        analyzeImage(file, analyzer);
+        analyzeImage(file, analyzer, decode_max_side);
     }
 }
 
-void compareModels() {
+// 黄金回归测试: 在进程内与Python参考输出逐阶段比对，返回进程退出码
+int compareModels(const std::string& model_path,
+                  const std::string& frontalization_path,
+                  const std::string& shape_predictor_path,
+                  const std::string& fixture_path) {
     std::cout << "===============================\n";
     std::cout << "Starting model comparison tests\n";
     std::cout << "===============================\n";
     
-    // Initialize emotion analyzer for comparison
-    std::string model_path = "model_emotion_pls30.onnx";
-    std::string shape_predictor_path = "shape_predictor_68_face_landmarks.dat";
-    std::string frontalization_path = "model_frontalization.npy";
-    
     auto analyzer = std::make_shared<EmotionAnalyzer>(model_path, frontalization_path, shape_predictor_path);
     
-    if (!analyzer->initialize()) {
+    // The golden fixtures start from landmarks, so detection models are never needed
+    if (!analyzer->initialize(EmotionAnalyzer::FRONTALIZE | EmotionAnalyzer::INFER)) {
         std::cerr << "Failed to initialize emotion analyzer for comparison" << std::endl;
-        return;
-    }    ModelComparison comparison(analyzer);    // Test images with absolute paths
-    std::vector<std::string> test_images = {
-        "D:/pythonpro/facial-expression-analysis-main/data/images/angry.jpg",
-        "D:/pythonpro/facial-expression-analysis-main/data/images/pleased.jpg",
-        "D:/pythonpro/facial-expression-analysis-main/data/images/happy.jpg",
-        "D:/pythonpro/facial-expression-analysis-main/data/images/sad.jpg",
-        "D:/pythonpro/facial-expression-analysis-main/data/images/example.png"
-    };
+        return 1;
+    }
+    
+    ModelComparison comparison(analyzer);
+    GoldenParityResult result = comparison.runGoldenParityTest(fixture_path);
+    
+    std::cout << comparison.generateGoldenReport(result);
+    std::cout << "===============================\n";
+    
+    return result.success ? 0 : 1;
+}
+
+// 基准测试模式: 返回0表示通过，1表示运行失败，2表示相对基线退化
+int runBenchmark(EmotionAnalyzer& analyzer, const BenchmarkConfig& config,
+                 const std::string& baseline_path, const std::string& save_path) {
+    Benchmark benchmark(analyzer, config);
+    if (!benchmark.buildCorpus()) {
+        return 1;
+    }
+    
+    BenchmarkResult result = benchmark.run();
+    Benchmark::printResult(result);
+    
+    if (!save_path.empty() && Benchmark::saveBaseline(result, save_path)) {
+        std::cout << "基线已保存至: " << save_path << std::endl;
+    }
     
-    // Validate images exist
-    std::vector<std::string> valid_images;
-    for (const auto& img : test_images) {
-        cv::Mat test_img = cv::imread(img);
-        if (!test_img.empty()) {
-            valid_images.push_back(img);
-        } else {
-            std::cout << "Warning: Cannot load " << img << std::endl;
+    if (!baseline_path.empty()) {
+        BenchmarkResult baseline;
+        if (!Benchmark::loadBaseline(baseline_path, baseline)) {
+            return 1;
+        }
+        
+        std::string report;
+        bool passed = Benchmark::compareWithBaseline(result, baseline, config.regression_threshold, report);
+        std::cout << report;
+        if (!passed) {
+            std::cerr << "Benchmark regression beyond threshold" << std::endl;
+            return 2;
         }
     }
     
-    if (valid_images.empty()) {
-        std::cerr << "No valid test images found" << std::endl;
-        return;
+    return 0;
+}
+
+// 检测器配置扫描: 输出速度与召回率对照表
+int runDetectorSweep(EmotionAnalyzer& analyzer, const BenchmarkConfig& config) {
+    Benchmark benchmark(analyzer, config);
+    if (!benchmark.buildCorpus()) {
+        return 1;
     }
     
-    // Execute comparison
-    ComparisonResult result = comparison.compareWithPythonModel("../source/compare_with_cpp.py", valid_images);
+    Benchmark::printDetectorSweep(benchmark.runDetectorSweep(Benchmark::defaultDetectorSweep()));
+    return 0;
+}
+
+// 截断级联的精度报告: 相对完整级联的关键点RMSE与AV偏差
+int runLandmarkBudgetReport(EmotionAnalyzer& analyzer, const BenchmarkConfig& config) {
+    Benchmark benchmark(analyzer, config);
+    if (!benchmark.buildCorpus()) {
+        return 1;
+    }
     
-    // Print results
-    comparison.printComparisonResults(result);
+    Benchmark::printLandmarkBudgetReport(benchmark.runLandmarkBudgetReport(Benchmark::defaultLandmarkBudgets()));
+    return 0;
+}
+
+// 视频关键点跟踪报告
+int runTrackingReport(EmotionAnalyzer& analyzer, const BenchmarkConfig& config) {
+    Benchmark benchmark(analyzer, config);
+    if (!benchmark.buildCorpus()) {
+        return 1;
+    }
     
-    std::cout << "===============================\n";
+    // Tracking splits whatever cascades the budget leaves, so report a truncated budget as well
+    const ErtBudget saved = analyzer.getLandmarkBudget();
+    std::vector<ErtBudget> budgets{saved};
+    if (saved.full()) {
+        ErtBudget fast;
+        fast.cascades = 6;
+        budgets.push_back(fast);
+    }
+    
+    int status = 0;
+    for (const auto& budget : budgets) {
+        analyzer.setLandmarkBudget(budget);
+        TrackingReport report = benchmark.runTrackingReport();
+        if (report.frames == 0) {
+            std::cerr << "No frames with faces for the tracking report" << std::endl;
+            status = 1;
+            break;
+        }
+        Benchmark::printTrackingReport(report);
+    }
+    analyzer.setLandmarkBudget(saved);
+    return status;
+}
+
+// 模型热重载报告
+int runHotReloadReport(EmotionAnalyzer& analyzer, const BenchmarkConfig& config, const std::string& onnx_model_path) {
+    Benchmark benchmark(analyzer, config);
+    if (!benchmark.buildCorpus()) {
+        return 1;
+    }
+    
+    HotReloadReport report = benchmark.runHotReloadReport(onnx_model_path);
+    if (report.requests == 0) {
+        std::cerr << "Hot reload report failed" << std::endl;
+        return 1;
+    }
+    Benchmark::printHotReloadReport(report);
+    return report.failed_requests == 0 && report.mismatches == 0 && report.failed_reloads == 0 ? 0 : 1;
+}
+
+// 关键点回归器对比: dlib vs 内置ERT求值器
+int runLandmarkComparison(EmotionAnalyzer& analyzer, const BenchmarkConfig& config,
+                          const std::string& shape_predictor_path) {
+    Benchmark benchmark(analyzer, config);
+    if (!benchmark.buildCorpus()) {
+        return 1;
+    }
+    
+    LandmarkComparison comparison = benchmark.compareShapePredictors(shape_predictor_path);
+    if (comparison.faces == 0) {
+        return 1;
+    }
+    Benchmark::printLandmarkComparison(comparison);
+    
+    // Both evaluators round to whole pixels, so one rounding flip in x and y is at most sqrt(2) px;
+    // anything larger means a different tree path. Sub-pixel agreement is required on the mean
+    const double max_error_px = 1.5;
+    const double mean_error_px = 0.1;
+    if (comparison.max_error_px > max_error_px || comparison.mean_error_px > mean_error_px) {
+        std::cerr << "Native landmarks deviate from dlib (limits: max " << max_error_px
+                  << " px, mean " << mean_error_px << " px)" << std::endl;
+        return 1;
+    }
+    return 0;
 }
 
 int main(int argc, char* argv[]) {
@@ -125,6 +293,28 @@ int main(int argc, char* argv[]) {
     std::string model_path = "model_emotion_pls30.onnx";
     std::string shape_predictor_path = "shape_predictor_68_face_landmarks.dat";
     std::string frontalization_path = "model_frontalization.npy";
+    std::string data_dir = "../data";
+    std::string fixture_path;
+    bool benchmark_mode = false;
+    bool detector_sweep = false;
+    bool landmark_compare = false;
+    bool native_landmarks = true;
+    bool landmark_report = false;
+    bool tracking_report = false;
+    bool hot_reload_report = false;
+    bool ort_cache_report = false;
+    OnnxSessionConfig onnx_session_config;
+    int shared_models = 0;
+    std::string export_flat_path;
+    LandmarkTracking landmark_tracking;
+    ErtBudget landmark_budget;
+    DetectorConfig detector_config;
+    int decode_max_side = ImageDecode::kDefaultTargetMaxSide;
+    int warmup_iterations = 0;
+    cv::Size warmup_size(640, 480);
+    BenchmarkConfig benchmark_config;
+    std::string baseline_path;
+    std::string save_baseline_path;
     
     // Parse command line arguments
     bool compare_mode = false;
@@ -140,6 +330,155 @@ int main(int argc, char* argv[]) {
             return 0;
         } else if (arg == "-c" || arg == "--compare") {
             compare_mode = true;
+        } else if (arg == "-g" || arg == "--golden") {
+            compare_mode = true;
+            if (i + 1 < argc) {
+                fixture_path = argv[++i];
+            } else {
+                std::cerr << "Error: --golden requires a fixture path" << std::endl;
+                return 1;
+            }
+        } else if (arg == "--data-dir") {
+            if (i + 1 < argc) {
+                data_dir = argv[++i];
+            }
+        } else if (arg == "--benchmark") {
+            benchmark_mode = true;
+        } else if (arg == "--baseline") {
+            if (i + 1 < argc) {
+                baseline_path = argv[++i];
+            }
+        } else if (arg == "--save-baseline") {
+            if (i + 1 < argc) {
+                save_baseline_path = argv[++i];
+            }
+        } else if (arg == "--threshold") {
+            if (i + 1 < argc) {
+                benchmark_config.regression_threshold = std::atof(argv[++i]);
+            }
+        } else if (arg == "--bench-iterations") {
+            if (i + 1 < argc) {
+                benchmark_config.iterations = std::max(1, std::atoi(argv[++i]));
+            }
+        } else if (arg == "--detector-sweep") {
+            detector_sweep = true;
+        } else if (arg == "--landmark-compare") {
+            landmark_compare = true;
+        } else if (arg == "--landmark-cascades") {
+            if (i + 1 < argc) {
+                landmark_budget.cascades = std::max(0, std::atoi(argv[++i]));
+            }
+        } else if (arg == "--landmark-trees") {
+            if (i + 1 < argc) {
+                landmark_budget.trees = std::max(0, std::atoi(argv[++i]));
+            }
+        } else if (arg == "--export-flat-landmarks") {
+            if (i + 1 < argc) {
+                export_flat_path = argv[++i];
+            }
+        } else if (arg == "--shared-models") {
+            if (i + 1 < argc) {
+                shared_models = std::max(0, std::atoi(argv[++i]));
+            }
+        } else if (arg == "--track-landmarks") {
+            landmark_tracking.enabled = true;
+        } else if (arg == "--tracking-report") {
+            tracking_report = true;
+        } else if (arg == "--hot-reload-report") {
+            hot_reload_report = true;
+        } else if (arg == "--ort-opt") {
+            if (i + 1 < argc) {
+                onnx_session_config.optimization_level = std::atoi(argv[++i]);
+                if (onnx_session_config.optimization_level < 0 || onnx_session_config.optimization_level > 3) {
+                    std::cerr << "Error: --ort-opt must be 0, 1, 2 or 3" << std::endl;
+                    return 1;
+                }
+            }
+        } else if (arg == "--ort-cache-dir") {
+            if (i + 1 < argc) {
+                onnx_session_config.cache_dir = argv[++i];
+            }
+        } else if (arg == "--no-ort-cache") {
+            onnx_session_config.cache = false;
+        } else if (arg == "--ort-cache-report") {
+            ort_cache_report = true;
+        } else if (arg == "--landmark-report") {
+            landmark_report = true;
+        } else if (arg == "--dlib-landmarks") {
+            native_landmarks = false;
+        } else if (arg == "--detector") {
+            if (i + 1 < argc && !FaceDetection::parseBackend(argv[++i], detector_config)) {
+                std::cerr << "Error: --detector expects hog, haar, lbp or a cascade .xml file" << std::endl;
+                return 1;
+            }
+        } else if (arg == "--min-face") {
+            if (i + 1 < argc) {
+                detector_config.min_face_size = std::max(0, std::atoi(argv[++i]));
+            }
+        } else if (arg == "--max-face") {
+            if (i + 1 < argc) {
+                detector_config.max_face_size = std::max(0, std::atoi(argv[++i]));
+            }
+        } else if (arg == "--pyramid-ratio") {
+            if (i + 1 < argc) {
+                detector_config.pyramid_ratio = std::atof(argv[++i]);
+                if (detector_config.pyramid_ratio <= 0.0 || detector_config.pyramid_ratio >= 1.0) {
+                    std::cerr << "Error: --pyramid-ratio must be in (0, 1)" << std::endl;
+                    return 1;
+                }
+            }
+        } else if (arg == "--det-threshold") {
+            if (i + 1 < argc) {
+                detector_config.threshold = std::atof(argv[++i]);
+            }
+        } else if (arg == "--upsample") {
+            if (i + 1 < argc) {
+                detector_config.upsample = std::max(0, std::atoi(argv[++i]));
+            }
+        } else if (arg == "--det-threads") {
+            if (i + 1 < argc) {
+                detector_config.threads = std::max(0, std::atoi(argv[++i]));
+            }
+        } else if (arg == "--tile") {
+            if (i + 1 < argc) {
+                detector_config.tile_size = std::max(0, std::atoi(argv[++i]));
+            }
+        } else if (arg == "--tile-overlap") {
+            if (i + 1 < argc) {
+                detector_config.tile_overlap = std::max(0, std::atoi(argv[++i]));
+            }
+        } else if (arg == "--ladder") {
+            detector_config.ladder = true;
+            // Optional comma-separated list of minimum face sizes, largest first
+            if (i + 1 < argc && argv[i + 1][0] != '-') {
+                std::vector<int> sizes;
+                for (const auto& token : Utils::splitString(argv[++i], ',')) {
+                    sizes.push_back(std::atoi(token.c_str()));
+                }
+                if (sizes.empty() || !std::is_sorted(sizes.rbegin(), sizes.rend()) || sizes.back() <= 0) {
+                    std::cerr << "Error: --ladder expects decreasing face sizes, e.g. 160,80,40" << std::endl;
+                    return 1;
+                }
+                detector_config.ladder_min_faces = sizes;
+            }
+        } else if (arg == "--decode-max-side") {
+            if (i + 1 < argc) {
+                decode_max_side = std::max(0, std::atoi(argv[++i]));
+            }
+        } else if (arg == "--warmup") {
+            if (i + 1 < argc) {
+                warmup_iterations = std::max(0, std::atoi(argv[++i]));
+            }
+        } else if (arg == "--warmup-size") {
+            if (i + 1 < argc) {
+                int width = 0, height = 0;
+                if (std::sscanf(argv[++i], "%dx%d", &width, &height) == 2 && width > 0 && height > 0) {
+                    warmup_size = cv::Size(width, height);
+                } else {
+                    std::cerr << "Error: --warmup-size expects WxH, e.g. 1280x720" << std::endl;
+                    return 1;
+                }
+            }
         } else if (arg == "-v" || arg == "--verbose") {
             verbose = true;
         } else if (arg == "-i" || arg == "--image") {
@@ -171,27 +510,94 @@ int main(int argc, char* argv[]) {
         }
     }
     
+    if (fixture_path.empty()) {
+        fixture_path = data_dir + "/golden/golden_fixtures.bin";
+    }
+    
     if (compare_mode) {
-        compareModels();
+        // CTest reports exit code 77 as skipped: a checkout without the fixture has nothing to compare
+        if (!Utils::fileExists(fixture_path)) {
+            std::cerr << "Golden fixtures not found: " << fixture_path
+                      << " (run generate_golden_fixtures.py with the model files)" << std::endl;
+            return 77;
+        }
+        return compareModels(model_path, frontalization_path, shape_predictor_path, fixture_path);
+    }
+    
+    if (!export_flat_path.empty()) {
+        ErtShapePredictor predictor;
+        if (!predictor.load(shape_predictor_path) || !predictor.saveFlat(export_flat_path)) {
+            return 1;
+        }
+        std::cout << "Flat shape predictor written to " << export_flat_path << " ("
+                  << predictor.modelBytes() / (1024 * 1024) << " MB)" << std::endl;
+        return 0;
+    }
+    
+    if (ort_cache_report) {
+        OnnxCacheReport report = Benchmark::runOnnxCacheReport(model_path, onnx_session_config,
+                                                               benchmark_config.iterations);
+        if (!report.available) {
+            return 1;
+        }
+        Benchmark::printOnnxCacheReport(report);
+        return 0;
+    }
+    
+    if (shared_models > 0) {
+        // Before any other analyzer, so the first one pays the real load
+        SharedModelReport report = Benchmark::runSharedModelReport(
+            model_path, frontalization_path, shape_predictor_path, detector_config, shared_models);
+        if (report.analyzers == 0) {
+            return 1;
+        }
+        Benchmark::printSharedModelReport(report);
         return 0;
     }
     
     // Initialize emotion analyzer
     EmotionAnalyzer analyzer(model_path, frontalization_path, shape_predictor_path);
+    analyzer.setDetectorConfig(detector_config);
+    analyzer.setNativeShapePredictor(native_landmarks);
+    analyzer.setLandmarkBudget(landmark_budget);
+    analyzer.setLandmarkTracking(landmark_tracking);
+    analyzer.setOnnxSessionConfig(onnx_session_config);
     
     if (!analyzer.initialize()) {
         std::cerr << "Failed to initialize emotion analyzer" << std::endl;
         return 1;
     }
     
+    if (warmup_iterations > 0) {
+        analyzer.warmup(warmup_iterations, warmup_size);
+    }
+    
     // Execute based on mode
-    if (!image_path.empty()) {
-        analyzeImage(image_path, analyzer);
+    if (detector_sweep) {
+        benchmark_config.image_dir = data_dir + "/images";
+        return runDetectorSweep(analyzer, benchmark_config);
+    } else if (tracking_report) {
+        benchmark_config.image_dir = data_dir + "/images";
+        return runTrackingReport(analyzer, benchmark_config);
+    } else if (hot_reload_report) {
+        benchmark_config.image_dir = data_dir + "/images";
+        return runHotReloadReport(analyzer, benchmark_config, model_path);
+    } else if (landmark_report) {
+        benchmark_config.image_dir = data_dir + "/images";
+        return runLandmarkBudgetReport(analyzer, benchmark_config);
+    } else if (landmark_compare) {
+        benchmark_config.image_dir = data_dir + "/images";
+        return runLandmarkComparison(analyzer, benchmark_config, shape_predictor_path);
+    } else if (benchmark_mode) {
+        benchmark_config.image_dir = data_dir + "/images";
+        return runBenchmark(analyzer, benchmark_config, baseline_path, save_baseline_path);
+    } else if (!image_path.empty()) {
+        analyzeImage(image_path, analyzer, decode_max_side);
     } else if (!batch_directory.empty()) {
-        batchAnalyze(batch_directory, analyzer);
+        batchAnalyze(batch_directory, analyzer, decode_max_side);
     } else {
         // Default behavior - compare models
-        compareModels();
+        return compareModels(model_path, frontalization_path, shape_predictor_path, fixture_path);
     }
     
     return 0;
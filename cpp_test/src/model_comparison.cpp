@@ -1,12 +1,53 @@
 #include "model_comparison.h"
+#include "landmark_kernels.h"
 #include "utils.h"
 #include <iostream>
 #include <fstream>
 #include <sstream>
 #include <cstdlib>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <chrono>
+#include <limits>
 #include <random>
 #include <iomanip>
 
+namespace {
+
+// 黄金回归数据文件头
+const char kGoldenMagic[8] = {'E', 'M', 'O', 'G', 'O', 'L', 'D', '1'};
+constexpr uint32_t kGoldenVersion = 1;
+
+// 各阶段容差: Python参考实现为float64，C++为float32；Python将AV取整到3位小数
+constexpr float kStandardizeTolerance = 1e-5f;
+constexpr float kFrontalTolerance = 1e-4f;
+constexpr float kFeatureTolerance = 1e-4f;
+constexpr float kPredictionTolerance = 1e-3f;
+constexpr float kResultTolerance = 2e-3f;
+
+template <typename T>
+bool readArray(std::ifstream& file, std::vector<T>& values, size_t count) {
+    values.resize(count);
+    file.read(reinterpret_cast<char*>(values.data()), static_cast<std::streamsize>(count * sizeof(T)));
+    return static_cast<bool>(file);
+}
+
+// Point2f关键点 -> [x1..x68, y1..y68]
+bool toPlanar(const std::vector<cv::Point2f>& landmarks, float* out) {
+    if (landmarks.size() != static_cast<size_t>(LandmarkKernels::kNumLandmarks)) {
+        return false;
+    }
+    for (int i = 0; i < LandmarkKernels::kNumLandmarks; ++i) {
+        out[i] = landmarks[i].x;
+        out[LandmarkKernels::kNumLandmarks + i] = landmarks[i].y;
+    }
+    return true;
+}
+
+} // namespace
+
 ModelComparison::ModelComparison(std::shared_ptr<EmotionAnalyzer> analyzer)
     : analyzer_(analyzer) {
 }
@@ -160,6 +201,366 @@ ComparisonResult ModelComparison::testRandomInputConsistency(int num_samples, in
     return result;
 }
 
+ComparisonResult ModelComparison::testBatchFrontalizationConsistency(int num_faces) {
+    ComparisonResult result;
+    result.success = false;
+    
+    try {
+        std::cout << "测试批量正面化一致性..." << std::endl;
+        std::cout << "人脸数: " << num_faces << std::endl;
+        
+        std::vector<std::vector<cv::Point2f>> landmarks_batch;
+        for (int i = 0; i < num_faces; ++i) {
+            landmarks_batch.push_back(generateRandomLandmarks());
+        }
+        
+        // 批量GEMM结果
+        auto batch_frontal = analyzer_->frontalizeLandmarksBatch(landmarks_batch);
+        
+        std::vector<std::vector<float>> batch_predictions;
+        std::vector<std::vector<float>> single_predictions;
+        
+        for (size_t i = 0; i < landmarks_batch.size(); ++i) {
+            // 逐个人脸的GEMV结果作为参考
+            auto single_frontal = analyzer_->frontalizeLandmarks(landmarks_batch[i]);
+            
+            std::vector<float> batch_row, single_row;
+            for (const auto& p : batch_frontal[i]) {
+                batch_row.push_back(p.x);
+                batch_row.push_back(p.y);
+            }
+            for (const auto& p : single_frontal) {
+                single_row.push_back(p.x);
+                single_row.push_back(p.y);
+            }
+            batch_predictions.push_back(batch_row);
+            single_predictions.push_back(single_row);
+        }
+        
+        result.cpp_predictions = batch_predictions;
+        result.python_predictions = single_predictions;
+        calculateDifferenceStats(batch_predictions, single_predictions, result);
+        
+        result.success = result.error_message.empty();
+        std::cout << "Batch frontalization consistency test completed" << std::endl;
+        
+    } catch (const std::exception& e) {
+        result.error_message = std::string("批量正面化测试中发生异常: ") + e.what();
+        std::cerr << result.error_message << std::endl;
+    }
+    
+    return result;
+}
+
+ComparisonResult ModelComparison::testFusedFeatureConsistency(int num_faces) {
+    ComparisonResult result;
+    result.success = false;
+    
+    try {
+        std::cout << "测试融合特征内核一致性..." << std::endl;
+        std::cout << "人脸数: " << num_faces << std::endl;
+        
+        std::vector<std::vector<float>> fused_predictions;
+        std::vector<std::vector<float>> staged_predictions;
+        
+        for (int i = 0; i < num_faces; ++i) {
+            std::vector<cv::Point2f> landmarks = generateRandomLandmarks();
+            
+            // 分步实现作为参考
+            std::vector<float> staged = analyzer_->extractGeometricFeatures(
+                analyzer_->frontalizeLandmarks(landmarks));
+            
+            std::vector<float> fused(staged.size());
+            int count = analyzer_->extractFeaturesFused(landmarks, fused.data(), fused.size());
+            fused.resize(count);
+            
+            fused_predictions.push_back(fused);
+            staged_predictions.push_back(staged);
+        }
+        
+        result.cpp_predictions = fused_predictions;
+        result.python_predictions = staged_predictions;
+        calculateDifferenceStats(fused_predictions, staged_predictions, result);
+        
+        result.success = result.error_message.empty();
+        std::cout << "Fused feature consistency test completed" << std::endl;
+        
+    } catch (const std::exception& e) {
+        result.error_message = std::string("融合特征测试中发生异常: ") + e.what();
+        std::cerr << result.error_message << std::endl;
+    }
+    
+    return result;
+}
+
+bool ModelComparison::loadGoldenFixtures(const std::string& fixture_path, GoldenFixtures& fixtures,
+                                         std::string& error) {
+    std::ifstream file(fixture_path, std::ios::binary | std::ios::ate);
+    if (!file.is_open()) {
+        error = "无法打开黄金回归数据: " + fixture_path + "（先运行 generate_golden_fixtures.py 生成）";
+        return false;
+    }
+    const uint64_t file_size = static_cast<uint64_t>(file.tellg());
+    file.seekg(0);
+    
+    char magic[8];
+    uint32_t header[5];  // version, num_cases, num_landmarks, feature_dim, full_features
+    file.read(magic, sizeof(magic));
+    file.read(reinterpret_cast<char*>(header), sizeof(header));
+    if (!file || std::memcmp(magic, kGoldenMagic, sizeof(magic)) != 0) {
+        error = "黄金回归数据格式无效: " + fixture_path;
+        return false;
+    }
+    if (header[0] != kGoldenVersion || header[2] != static_cast<uint32_t>(LandmarkKernels::kNumLandmarks)) {
+        error = "不支持的黄金回归数据版本或关键点数";
+        return false;
+    }
+    
+    // The header sizes decide every allocation below, so check them against the file first
+    const bool full_features = header[4] != 0;
+    if (header[3] != static_cast<uint32_t>(LandmarkKernels::featureCount(full_features))) {
+        error = "黄金回归数据的特征维度无效: " + std::to_string(header[3]);
+        return false;
+    }
+    const uint64_t floats_per_case = 2 * LandmarkKernels::kNumLandmarks + LandmarkKernels::kFrontalInputDim +
+                                     LandmarkKernels::kFrontalOutputDim + header[3] + 2 + 3;
+    const uint64_t bytes_per_case = floats_per_case * sizeof(float) + 2 * sizeof(int);
+    const uint64_t header_bytes = sizeof(magic) + sizeof(header);
+    if (header[1] == 0 || file_size - header_bytes != static_cast<uint64_t>(header[1]) * bytes_per_case) {
+        error = "黄金回归数据大小与文件头不符: " + fixture_path;
+        return false;
+    }
+    
+    fixtures.num_cases = static_cast<int>(header[1]);
+    fixtures.feature_dim = static_cast<int>(header[3]);
+    fixtures.full_features = full_features;
+    
+    const size_t n = fixtures.num_cases;
+    const bool ok =
+        readArray(file, fixtures.raw_landmarks, n * 2 * LandmarkKernels::kNumLandmarks) &&
+        readArray(file, fixtures.standardized, n * LandmarkKernels::kFrontalInputDim) &&
+        readArray(file, fixtures.frontal, n * LandmarkKernels::kFrontalOutputDim) &&
+        readArray(file, fixtures.features, n * fixtures.feature_dim) &&
+        readArray(file, fixtures.prediction, n * 2) &&
+        readArray(file, fixtures.avi, n * 3) &&
+        readArray(file, fixtures.label_id, n) &&
+        readArray(file, fixtures.intensity_level, n);
+    
+    if (!ok) {
+        error = "黄金回归数据不完整: " + fixture_path;
+        return false;
+    }
+    
+    return true;
+}
+
+GoldenStageResult ModelComparison::compareGoldenStage(const std::string& stage, float tolerance,
+                                                      const std::vector<float>& actual,
+                                                      const std::vector<float>& expected,
+                                                      int num_cases, int dim) {
+    GoldenStageResult result;
+    result.stage = stage;
+    result.tolerance = tolerance;
+    result.max_difference = 0.0f;
+    result.mean_difference = 0.0f;
+    result.failed_cases = 0;
+    
+    double sum = 0.0;
+    for (int i = 0; i < num_cases; ++i) {
+        float case_max = 0.0f;
+        for (int j = 0; j < dim; ++j) {
+            const size_t idx = static_cast<size_t>(i) * dim + j;
+            const float diff = std::abs(actual[idx] - expected[idx]);
+            // NaN never compares greater, so count it as a failure explicitly
+            if (diff > case_max || std::isnan(diff)) {
+                case_max = std::isnan(diff) ? std::numeric_limits<float>::infinity() : diff;
+            }
+            sum += diff;
+        }
+        if (case_max > tolerance) {
+            result.failed_cases++;
+        }
+        result.max_difference = std::max(result.max_difference, case_max);
+    }
+    
+    if (num_cases > 0 && dim > 0) {
+        result.mean_difference = static_cast<float>(sum / (static_cast<double>(num_cases) * dim));
+    }
+    result.passed = (result.failed_cases == 0);
+    return result;
+}
+
+GoldenParityResult ModelComparison::runGoldenParityTest(const std::string& fixture_path) {
+    GoldenParityResult result;
+    result.success = false;
+    result.num_cases = 0;
+    result.elapsed_ms = 0.0;
+    
+    GoldenFixtures fixtures;
+    if (!loadGoldenFixtures(fixture_path, fixtures, result.error_message)) {
+        std::cerr << result.error_message << std::endl;
+        return result;
+    }
+    
+    const int n = fixtures.num_cases;
+    const int raw_dim = 2 * LandmarkKernels::kNumLandmarks;
+    const int row_dim = LandmarkKernels::kFrontalInputDim;
+    const int frontal_dim = LandmarkKernels::kFrontalOutputDim;
+    const int feature_dim = fixtures.feature_dim;
+    result.num_cases = n;
+    
+    std::cout << "黄金回归测试: " << n << " 个样本, 特征维度 " << feature_dim << std::endl;
+    auto start = std::chrono::steady_clock::now();
+    
+    try {
+        std::vector<std::vector<cv::Point2f>> landmarks(n);
+        for (int i = 0; i < n; ++i) {
+            const float* raw = &fixtures.raw_landmarks[static_cast<size_t>(i) * raw_dim];
+            for (int k = 0; k < LandmarkKernels::kNumLandmarks; ++k) {
+                landmarks[i].emplace_back(raw[2 * k], raw[2 * k + 1]);
+            }
+        }
+        
+        // 1. Procrustes标准化
+        std::vector<float> standardized(static_cast<size_t>(n) * row_dim);
+        for (int i = 0; i < n; ++i) {
+            LandmarkKernels::standardizeToFeatureRow(&fixtures.raw_landmarks[static_cast<size_t>(i) * raw_dim],
+                                                     &standardized[static_cast<size_t>(i) * row_dim]);
+        }
+        result.stages.push_back(compareGoldenStage("standardize", kStandardizeTolerance,
+                                                   standardized, fixtures.standardized, n, row_dim));
+        
+        // 2. 正面化（逐个GEMV与批量GEMM）
+        std::vector<float> frontal(static_cast<size_t>(n) * frontal_dim);
+        std::vector<float> frontal_batch(static_cast<size_t>(n) * frontal_dim);
+        auto batch = analyzer_->frontalizeLandmarksBatch(landmarks);
+        if (batch.size() != static_cast<size_t>(n)) {
+            result.error_message = "批量正面化结果数量不匹配";
+            return result;
+        }
+        for (int i = 0; i < n; ++i) {
+            if (!toPlanar(analyzer_->frontalizeLandmarks(landmarks[i]), &frontal[static_cast<size_t>(i) * frontal_dim]) ||
+                !toPlanar(batch[i], &frontal_batch[static_cast<size_t>(i) * frontal_dim])) {
+                result.error_message = "正面化关键点数量不匹配";
+                return result;
+            }
+        }
+        result.stages.push_back(compareGoldenStage("frontalize", kFrontalTolerance,
+                                                   frontal, fixtures.frontal, n, frontal_dim));
+        result.stages.push_back(compareGoldenStage("frontalize_batch", kFrontalTolerance,
+                                                   frontal_batch, fixtures.frontal, n, frontal_dim));
+        
+        // 3. 几何特征（分步实现与融合内核）
+        std::vector<float> staged(static_cast<size_t>(n) * feature_dim);
+        std::vector<float> fused(static_cast<size_t>(n) * feature_dim);
+        for (int i = 0; i < n; ++i) {
+            auto features = analyzer_->extractGeometricFeatures(analyzer_->frontalizeLandmarks(landmarks[i]));
+            int count = analyzer_->extractFeaturesFused(landmarks[i], &fused[static_cast<size_t>(i) * feature_dim],
+                                                        feature_dim);
+            if (features.size() != static_cast<size_t>(feature_dim) || count != feature_dim) {
+                result.error_message = "特征维度不匹配: 模型配置与黄金数据的full_features不一致";
+                return result;
+            }
+            std::copy(features.begin(), features.end(), staged.begin() + static_cast<size_t>(i) * feature_dim);
+        }
+        result.stages.push_back(compareGoldenStage("features", kFeatureTolerance,
+                                                   staged, fixtures.features, n, feature_dim));
+        result.stages.push_back(compareGoldenStage("features_fused", kFeatureTolerance,
+                                                   fused, fixtures.features, n, feature_dim));
+        
+        // 4. ONNX推理（输入为黄金特征，只比较推理本身）
+        std::vector<float> prediction(static_cast<size_t>(n) * 2);
+        for (int i = 0; i < n; ++i) {
+            std::vector<float> features(fixtures.features.begin() + static_cast<size_t>(i) * feature_dim,
+                                        fixtures.features.begin() + static_cast<size_t>(i + 1) * feature_dim);
+            auto output = analyzer_->predictWithONNX(features);
+            if (output.size() < 2) {
+                result.error_message = "ONNX推理输出维度不足";
+                return result;
+            }
+            prediction[2 * i] = output[0];
+            prediction[2 * i + 1] = output[1];
+        }
+        result.stages.push_back(compareGoldenStage("prediction", kPredictionTolerance,
+                                                   prediction, fixtures.prediction, n, 2));
+        
+        // 5. 工作区端到端路径（关键点 -> AVI）
+        AnalysisWorkspace workspace;
+        if (!analyzer_->prepareWorkspace(workspace)) {
+            result.error_message = "工作区准备失败";
+            return result;
+        }
+        std::vector<float> avi(static_cast<size_t>(n) * 3);
+        EmotionResult emotion;
+        for (int i = 0; i < n; ++i) {
+            if (!analyzer_->analyzeLandmarks(landmarks[i], workspace, emotion)) {
+                result.error_message = "工作区分析失败";
+                return result;
+            }
+            avi[3 * i] = emotion.arousal;
+            avi[3 * i + 1] = emotion.valence;
+            avi[3 * i + 2] = emotion.intensity;
+        }
+        result.stages.push_back(compareGoldenStage("avi", kResultTolerance, avi, fixtures.avi, n, 3));
+        
+        // 6. 情绪标签（输入为Python的AV，编码必须完全一致）
+        std::vector<float> codes(static_cast<size_t>(n) * 2), expected_codes(static_cast<size_t>(n) * 2);
+        for (int i = 0; i < n; ++i) {
+            auto code = EmotionLabels::fromAVI(fixtures.avi[3 * i], fixtures.avi[3 * i + 1]);
+            codes[2 * i] = static_cast<float>(code.quadrant_label_id);
+            codes[2 * i + 1] = static_cast<float>(code.intensity_level);
+            expected_codes[2 * i] = static_cast<float>(fixtures.label_id[i]);
+            expected_codes[2 * i + 1] = static_cast<float>(fixtures.intensity_level[i]);
+        }
+        result.stages.push_back(compareGoldenStage("label", 0.0f, codes, expected_codes, n, 2));
+        
+    } catch (const std::exception& e) {
+        result.error_message = std::string("黄金回归测试中发生异常: ") + e.what();
+        std::cerr << result.error_message << std::endl;
+        return result;
+    }
+    
+    result.elapsed_ms = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start).count();
+    
+    result.success = true;
+    for (const auto& stage : result.stages) {
+        result.success = result.success && stage.passed;
+    }
+    
+    return result;
+}
+
+std::string ModelComparison::generateGoldenReport(const GoldenParityResult& result) {
+    std::stringstream report;
+    
+    report << "========== 黄金回归测试报告 ==========\n";
+    report << "时间: " << Utils::getCurrentTimeString() << "\n";
+    
+    if (!result.error_message.empty()) {
+        report << "❌ 测试失败: " << result.error_message << "\n";
+        return report.str();
+    }
+    
+    report << "样本数: " << result.num_cases << "\n";
+    report << "耗时: " << std::fixed << std::setprecision(2) << result.elapsed_ms << " ms\n\n";
+    
+    report << std::left << std::setw(18) << "阶段" << std::setw(12) << "容差"
+           << std::setw(14) << "最大差异" << std::setw(14) << "平均差异" << "失败样本\n";
+    for (const auto& stage : result.stages) {
+        report << std::left << std::setw(18) << stage.stage
+               << std::scientific << std::setprecision(1) << std::setw(12) << stage.tolerance
+               << std::setprecision(3) << std::setw(14) << stage.max_difference
+               << std::setw(14) << stage.mean_difference
+               << stage.failed_cases << (stage.passed ? "  ✅" : "  ❌") << "\n";
+    }
+    
+    report << "\n总体结果: " << (result.success ? "✅ 所有阶段通过" : "❌ 存在超出容差的阶段") << "\n";
+    report << "=====================================\n";
+    
+    return report.str();
+}
+
 std::vector<std::vector<float>> ModelComparison::loadPythonPredictions(const std::string& results_file) {
     std::vector<std::vector<float>> predictions;
     
@@ -332,11 +733,30 @@ std::vector<float> ModelComparison::generateRandomFeatureVector(int dims) {
     return features;
 }
 
+std::vector<cv::Point2f> ModelComparison::generateRandomLandmarks() {
+    static std::mt19937 gen(42);
+    std::uniform_real_distribution<float> center_dis(100.0f, 500.0f);
+    std::uniform_real_distribution<float> scale_dis(40.0f, 150.0f);
+    std::normal_distribution<float> point_dis(0.0f, 1.0f);
+    
+    const float cx = center_dis(gen);
+    const float cy = center_dis(gen);
+    const float scale = scale_dis(gen);
+    
+    std::vector<cv::Point2f> landmarks;
+    landmarks.reserve(68);
+    for (int i = 0; i < 68; ++i) {
+        landmarks.emplace_back(cx + scale * point_dis(gen), cy + scale * point_dis(gen));
+    }
+    
+    return landmarks;
+}
+
 void ModelComparison::printComparisonResults(const ComparisonResult& result) {
     std::cout << generateReport(result) << std::endl;
 }
 
-bool ModelComparison::runFullValidationTest(const std::string& output_dir) {
+bool ModelComparison::runFullValidationTest(const std::string& output_dir, const std::string& fixture_path) {
     std::cout << "运行完整验证测试..." << std::endl;
     
     // 创建输出目录
@@ -345,50 +765,60 @@ bool ModelComparison::runFullValidationTest(const std::string& output_dir) {
     
     bool all_passed = true;
     
-    // 1. 随机输入一致性测试
-    std::cout << "\n1. 随机输入一致性测试" << std::endl;
-    ComparisonResult random_result = testRandomInputConsistency(10, 1275);
+    // 1. 黄金回归测试（进程内逐阶段与Python参考输出比对）
+    std::cout << "\n1. 黄金回归测试" << std::endl;
+    GoldenParityResult golden_result = runGoldenParityTest(fixture_path);
     
-    std::string random_report = generateReport(random_result);
-    std::ofstream random_file(output_dir + "/random_test_report.txt");
-    random_file << random_report;
-    random_file.close();
+    std::ofstream golden_file(output_dir + "/golden_parity_report.txt");
+    golden_file << generateGoldenReport(golden_result);
+    golden_file.close();
     
-    if (!random_result.success || random_result.max_difference > 1e-5) {
+    if (!golden_result.success) {
         all_passed = false;
-        std::cout << "❌ 随机输入测试失败" << std::endl;
+        std::cout << "❌ 黄金回归测试失败" << std::endl;
     } else {
-        std::cout << "✅ 随机输入测试通过" << std::endl;
+        std::cout << "✅ 黄金回归测试通过" << std::endl;
     }
     
-    // 2. 真实图像测试
-    std::cout << "\n2. 真实图像测试" << std::endl;
-    std::vector<std::string> test_images = {
-        "../data/images/pleased.jpg",
-        "../data/images/happy.jpg",
-        "../data/images/sad.jpg"
-    };
+    // 2. 批量正面化一致性测试
+    std::cout << "\n2. 批量正面化一致性测试" << std::endl;
+    ComparisonResult batch_result = testBatchFrontalizationConsistency(64);
+    
+    std::string batch_report = generateReport(batch_result);
+    std::ofstream batch_file(output_dir + "/batch_frontalization_report.txt");
+    batch_file << batch_report;
+    batch_file.close();
+    
+    if (!batch_result.success || batch_result.max_difference > 1e-4) {
+        all_passed = false;
+        std::cout << "❌ 批量正面化测试失败" << std::endl;
+    } else {
+        std::cout << "✅ 批量正面化测试通过" << std::endl;
+    }
     
-    ComparisonResult image_result = compareWithPythonModel("compare_image_predictions.py", test_images);
+    // 3. 融合特征内核一致性测试
+    std::cout << "\n3. 融合特征内核一致性测试" << std::endl;
+    ComparisonResult fused_result = testFusedFeatureConsistency(64);
     
-    std::string image_report = generateReport(image_result);
-    std::ofstream image_file(output_dir + "/image_test_report.txt");
-    image_file << image_report;
-    image_file.close();
+    std::string fused_report = generateReport(fused_result);
+    std::ofstream fused_file(output_dir + "/fused_feature_report.txt");
+    fused_file << fused_report;
+    fused_file.close();
     
-    if (!image_result.success || image_result.max_difference > 1e-3) {
+    if (!fused_result.success || fused_result.max_difference > 1e-4) {
         all_passed = false;
-        std::cout << "❌ 图像测试失败" << std::endl;
+        std::cout << "❌ 融合特征测试失败" << std::endl;
     } else {
-        std::cout << "✅ 图像测试通过" << std::endl;
+        std::cout << "✅ 融合特征测试通过" << std::endl;
     }
     
     // 生成总结报告
     std::ofstream summary_file(output_dir + "/validation_summary.txt");
     summary_file << "========== 验证测试总结 ==========\n";
     summary_file << "时间: " << Utils::getCurrentTimeString() << "\n\n";
-    summary_file << "随机输入测试: " << (random_result.success ? "通过" : "失败") << "\n";
-    summary_file << "图像预测测试: " << (image_result.success ? "通过" : "失败") << "\n\n";
+    summary_file << "黄金回归测试: " << (golden_result.success ? "通过" : "失败") << "\n";
+    summary_file << "批量正面化测试: " << (batch_result.success ? "通过" : "失败") << "\n";
+    summary_file << "融合特征测试: " << (fused_result.success ? "通过" : "失败") << "\n\n";
     summary_file << "总体结果: " << (all_passed ? "✅ 所有测试通过" : "❌ 存在失败的测试") << "\n";
     summary_file << "=====================================\n";
     summary_file.close();
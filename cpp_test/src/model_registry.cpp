@@ -0,0 +1,151 @@
+#include "model_registry.h"
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <unordered_map>
+
+namespace {
+
+// One registered model; its own mutex serialises loading without blocking other keys
+struct Slot {
+    std::mutex mutex;
+    std::weak_ptr<const void> model;
+};
+
+struct Registry {
+    std::mutex mutex;
+    std::unordered_map<uint64_t, std::shared_ptr<Slot>> slots;
+    long long loads = 0;
+    long long hits = 0;
+};
+
+Registry& registry() {
+    static Registry instance;
+    return instance;
+}
+
+constexpr uint64_t kFnvOffset = 14695981039346656037ull;
+constexpr uint64_t kFnvPrime = 1099511628211ull;
+
+void fnv1a(uint64_t& hash, const void* data, size_t size) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= bytes[i];
+        hash *= kFnvPrime;
+    }
+}
+
+}  // namespace
+
+uint64_t ModelRegistry::modelKey(const std::string& kind, const std::string& path) {
+    namespace fs = std::filesystem;
+    uint64_t hash = kFnvOffset;
+    fnv1a(hash, kind.data(), kind.size() + 1);
+
+    std::error_code ec;
+    const fs::path canonical = path.empty() ? fs::path() : fs::weakly_canonical(path, ec);
+    const std::string name = ec ? path : canonical.string();
+    fnv1a(hash, name.data(), name.size() + 1);
+
+    // The content, not size and mtime: a same-size replacement that keeps its mtime (cp -p,
+    // rsync -t) must not be served from the old model
+    uint64_t content = 0;
+    if (!path.empty() && contentHash(path, content)) {
+        fnv1a(hash, &content, sizeof(content));
+    }
+    return hash;
+}
+
+bool ModelRegistry::contentHash(const std::string& path, uint64_t& hash) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+    // FNV-1a over 64-bit words: every model acquire hashes its file, and a byte at a time the
+    // 95 MB shape predictor would take a noticeable part of startup
+    hash = kFnvOffset;
+    std::vector<char> buffer(1 << 16);
+    while (file.read(buffer.data(), buffer.size()) || file.gcount() > 0) {
+        const size_t count = static_cast<size_t>(file.gcount());
+        const size_t words = count / sizeof(uint64_t);
+        for (size_t i = 0; i < words; ++i) {
+            uint64_t word;
+            std::memcpy(&word, buffer.data() + i * sizeof(uint64_t), sizeof(word));
+            hash ^= word;
+            hash *= kFnvPrime;
+        }
+        fnv1a(hash, buffer.data() + words * sizeof(uint64_t), count - words * sizeof(uint64_t));
+    }
+    return true;
+}
+
+std::shared_ptr<const void> ModelRegistry::acquireShared(const std::string& kind, const std::string& path,
+                                                         const std::function<std::shared_ptr<const void>()>& load) {
+    const uint64_t key = modelKey(kind, path);
+    Registry& reg = registry();
+
+    std::shared_ptr<Slot> slot;
+    {
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        // Drop slots whose models have all been released (e.g. older versions of a replaced file).
+        // A slot that another acquire still holds may be mid-load with an empty weak_ptr; erasing
+        // it would let a third caller create a second slot and load the same model again
+        for (auto it = reg.slots.begin(); it != reg.slots.end();) {
+            if (it->first != key && it->second.use_count() == 1 && it->second->model.expired()) {
+                it = reg.slots.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        auto& entry = reg.slots[key];
+        if (!entry) {
+            entry = std::make_shared<Slot>();
+        }
+        slot = entry;
+    }
+
+    std::lock_guard<std::mutex> slot_lock(slot->mutex);
+    if (auto model = slot->model.lock()) {
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        ++reg.hits;
+        return model;
+    }
+
+    std::shared_ptr<const void> model = load();
+    if (model) {
+        slot->model = model;
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        ++reg.loads;
+    }
+    return model;
+}
+
+#ifdef DLIB_AVAILABLE
+std::shared_ptr<const dlib::frontal_face_detector> ModelRegistry::frontalFaceDetector() {
+    return acquire<dlib::frontal_face_detector>("dlib-frontal-face-detector", "", []() {
+        return std::make_shared<const dlib::frontal_face_detector>(dlib::get_frontal_face_detector());
+    });
+}
+#endif
+
+#ifdef ONNX_AVAILABLE
+Ort::Env& ModelRegistry::ortEnv() {
+    // Intentionally never destroyed: sessions held by g_analyzer and the registry slots are released
+    // during static destruction, possibly after a function-local Env would already be gone
+    static Ort::Env* env = new Ort::Env(ORT_LOGGING_LEVEL_ERROR, "EmotionAnalyzer");
+    return *env;
+}
+#endif
+
+ModelRegistryStats ModelRegistry::stats() {
+    Registry& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    ModelRegistryStats result;
+    result.loads = reg.loads;
+    result.hits = reg.hits;
+    for (const auto& entry : reg.slots) {
+        result.live += entry.second->model.expired() ? 0 : 1;
+    }
+    return result;
+}
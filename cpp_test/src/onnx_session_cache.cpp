@@ -0,0 +1,190 @@
+#include "onnx_session_cache.h"
+#include "model_registry.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <random>
+
+#ifndef _WIN32
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+namespace fs = std::filesystem;
+
+// Per-user cache root; a shared location like the temp directory would let other users plant models
+fs::path defaultCacheDirectory() {
+#ifdef _WIN32
+    const char* local = std::getenv("LOCALAPPDATA");
+    return local && local[0] ? fs::path(local) / "emotion_ort_cache" : fs::path();
+#else
+    const char* xdg = std::getenv("XDG_CACHE_HOME");
+    if (xdg && xdg[0] == '/') {
+        return fs::path(xdg) / "emotion_ort_cache";
+    }
+    const char* home = std::getenv("HOME");
+    return home && home[0] == '/' ? fs::path(home) / ".cache" / "emotion_ort_cache" : fs::path();
+#endif
+}
+
+// Anything loaded from the cache runs as our model, so only trust paths no other user can write
+bool ownedPrivately(const fs::path& path) {
+#ifdef _WIN32
+    (void)path;  // %LOCALAPPDATA% and explicit directories rely on the per-user profile ACLs
+    return true;
+#else
+    struct stat info;
+    return ::lstat(path.c_str(), &info) == 0 && info.st_uid == ::geteuid() && (info.st_mode & (S_IWGRP | S_IWOTH)) == 0;
+#endif
+}
+
+// Creates the cache directory owner-only and checks an existing one has not been opened up to others
+bool prepareCacheDirectory(const fs::path& dir) {
+    std::error_code ec;
+    if (fs::create_directories(dir, ec)) {
+        fs::permissions(dir, fs::perms::owner_all, fs::perm_options::replace, ec);
+    }
+    if (!fs::is_directory(dir, ec)) {
+        std::cerr << "Cannot create ORT cache directory " << dir.string() << std::endl;
+        return false;
+    }
+    if (!ownedPrivately(dir)) {
+        std::cerr << "Ignoring ORT cache directory " << dir.string()
+                  << ": it must be owned by the current user and not writable by others" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+#ifdef ONNX_AVAILABLE
+Ort::SessionOptions baseOptions() {
+    Ort::SessionOptions options;
+
+    // Set conservative settings for better compatibility
+    options.SetIntraOpNumThreads(1);
+    options.SetInterOpNumThreads(1);
+
+    // Disable CPU execution provider extensions that might cause issues
+    options.DisableCpuMemArena();
+    options.DisableMemPattern();
+    return options;
+}
+
+GraphOptimizationLevel ortLevel(int level) {
+    switch (level) {
+        case 0: return ORT_DISABLE_ALL;
+        case 1: return ORT_ENABLE_BASIC;
+        case 2: return ORT_ENABLE_EXTENDED;
+        default: return level < 0 ? ORT_DISABLE_ALL : ORT_ENABLE_ALL;
+    }
+}
+#endif
+
+}  // namespace
+
+std::string OnnxSessionCache::cachePath(const std::string& model_path, const OnnxSessionConfig& config) {
+    if (!config.cache || config.optimization_level <= 0) {
+        return "";
+    }
+    // Without a per-user location caching is off rather than falling back to a shared directory
+    const fs::path dir = config.cache_dir.empty() ? defaultCacheDirectory() : fs::path(config.cache_dir);
+    if (dir.empty()) {
+        return "";
+    }
+
+    uint64_t hash = 0;
+    if (!ModelRegistry::contentHash(model_path, hash)) {
+        return "";
+    }
+
+#ifdef ONNX_AVAILABLE
+    const std::string version = OrtGetApiBase()->GetVersionString();
+#else
+    const std::string version = "none";
+#endif
+
+    // The optimized graph depends on the model content, the ORT build and the optimization level
+    char name[64];
+    std::snprintf(name, sizeof(name), "-%016llx-ort", static_cast<unsigned long long>(hash));
+    const std::string file = fs::path(model_path).stem().string() + name + version + "-O" +
+                             std::to_string(std::min(config.optimization_level, 3)) + ".onnx";
+    return (dir / file).string();
+}
+
+#ifdef ONNX_AVAILABLE
+std::unique_ptr<Ort::Session> OnnxSessionCache::createSession(const std::string& model_path,
+                                                              const OnnxSessionConfig& config, bool* cache_hit) {
+    if (cache_hit) {
+        *cache_hit = false;
+    }
+
+    std::error_code ec;
+    std::string cached = cachePath(model_path, config);
+    if (!cached.empty() && !prepareCacheDirectory(fs::path(cached).parent_path())) {
+        cached.clear();
+    }
+    if (!cached.empty() && fs::exists(cached, ec) && !ownedPrivately(cached)) {
+        std::cerr << "Ignoring ORT cache " << cached << ": not owned by the current user or writable by others"
+                  << std::endl;
+        cached.clear();
+    }
+    if (!cached.empty() && fs::exists(cached, ec)) {
+        try {
+            // Already optimized, running the optimizers again would only add startup time
+            Ort::SessionOptions options = baseOptions();
+            options.SetGraphOptimizationLevel(ORT_DISABLE_ALL);
+            auto session = std::make_unique<Ort::Session>(ModelRegistry::ortEnv(), fs::path(cached).c_str(), options);
+            if (cache_hit) {
+                *cache_hit = true;
+            }
+            std::cout << "Loaded optimized ONNX model from cache " << cached << std::endl;
+            return session;
+        } catch (const Ort::Exception& e) {
+            std::cerr << "Discarding unreadable ORT cache " << cached << ": " << e.what() << std::endl;
+            fs::remove(cached, ec);
+        }
+    }
+
+    fs::path temp;
+    if (!cached.empty()) {
+        // A name of its own per writer; the finished file is renamed into place
+        temp = cached + "." + std::to_string(std::random_device{}()) + ".tmp";
+    }
+
+    std::unique_ptr<Ort::Session> session;
+    Ort::SessionOptions options = baseOptions();
+    options.SetGraphOptimizationLevel(ortLevel(config.optimization_level));
+    if (!temp.empty()) {
+        options.SetOptimizedModelFilePath(temp.c_str());
+        try {
+            session = std::make_unique<Ort::Session>(ModelRegistry::ortEnv(), fs::path(model_path).c_str(), options);
+        } catch (const Ort::Exception& e) {
+            // Saving is an optimization; retry without it before giving up on the model
+            std::cerr << "Cannot save optimized ONNX model: " << e.what() << std::endl;
+            fs::remove(temp, ec);
+            temp.clear();
+            options = baseOptions();
+            options.SetGraphOptimizationLevel(ortLevel(config.optimization_level));
+        }
+    }
+    if (!session) {
+        session = std::make_unique<Ort::Session>(ModelRegistry::ortEnv(), fs::path(model_path).c_str(), options);
+    }
+
+    if (!temp.empty()) {
+        fs::permissions(temp, fs::perms::owner_read | fs::perms::owner_write, fs::perm_options::replace, ec);
+        fs::rename(temp, cached, ec);
+        if (ec) {
+            // Another process got there first (Windows does not replace an existing file)
+            fs::remove(temp, ec);
+        } else {
+            std::cout << "Saved optimized ONNX model to " << cached << std::endl;
+        }
+    }
+    return session;
+}
+#endif
@@ -0,0 +1,65 @@
+// 热重载恢复测试: 用不存在的模型路径初始化（加载失败），确认工作区分析失败；
+// 再热重载为正确的模型，确认工作区分析和批量推理恢复，无需重新初始化分析器
+#include "emotion_analyzer.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <random>
+
+int main() {
+    std::cout << "=== 热重载恢复测试 ===" << std::endl;
+
+    EmotionAnalyzer analyzer("missing_emotion_model.onnx",
+                             "missing_frontalization.npy",
+                             "shape_predictor_68_face_landmarks.dat");
+    if (analyzer.initialize(EmotionAnalyzer::FRONTALIZE | EmotionAnalyzer::INFER)) {
+        std::cerr << "❌ 不存在的模型路径不应初始化成功" << std::endl;
+        return 1;
+    }
+
+    std::mt19937 gen(11);
+    std::normal_distribution<float> dis(0.0f, 1.0f);
+    std::vector<cv::Point2f> landmarks;
+    for (int i = 0; i < 68; ++i) {
+        landmarks.emplace_back(320.0f + 60.0f * dis(gen), 240.0f + 60.0f * dis(gen));
+    }
+
+    AnalysisWorkspace workspace;
+    EmotionResult result;
+    if (analyzer.analyzeLandmarks(landmarks, workspace, result)) {
+        std::cerr << "❌ 模型缺失时工作区分析不应成功" << std::endl;
+        return 1;
+    }
+
+    if (!analyzer.reloadModels("model_emotion_pls30.onnx", "model_frontalization.npy")) {
+        std::cerr << "❌ 热重载失败（需要模型文件位于工作目录）" << std::endl;
+        return 1;
+    }
+
+    bool passed = true;
+    const unsigned expected = EmotionAnalyzer::FRONTALIZE | EmotionAnalyzer::INFER;
+    if ((analyzer.loadedCapabilities() & expected) != expected) {
+        std::cerr << "❌ 重载后仍报告模型未加载" << std::endl;
+        passed = false;
+    }
+
+    // The workspace was never prepared; analyzeLandmarks prepares it against the reloaded models
+    if (!analyzer.analyzeLandmarks(landmarks, workspace, result) ||
+        !std::isfinite(result.arousal) || !std::isfinite(result.valence)) {
+        std::cerr << "❌ 重载后工作区分析失败" << std::endl;
+        passed = false;
+    } else {
+        std::cout << "工作区分析: arousal " << result.arousal << ", valence " << result.valence << std::endl;
+    }
+
+    // The batched inference entry point is gated on the same load state
+    auto prediction = analyzer.predictWithONNXBatch(workspace.features.data(), 1, workspace.features.size());
+    if (prediction.size() < 2 ||
+        std::abs(std::max(-1.0f, std::min(1.0f, prediction[0])) - result.arousal) > 1e-5f) {
+        std::cerr << "❌ 重载后批量推理失败或与工作区结果不一致" << std::endl;
+        passed = false;
+    }
+
+    std::cout << (passed ? "✅ 通过" : "❌ 失败") << std::endl;
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,186 @@
+// 数值内核黄金回归测试: 用 generate_golden_fixtures.py --kernels 从 source/emotions_dlib.py 生成的数据，
+// 逐阶段比对Procrustes标准化、正面化（GEMV、分块GEMM、打包GEMM）和几何特征（分步与融合）。
+// 数据使用合成关键点和随机正面化权重，不需要模型文件和Python运行时
+#include "landmark_kernels.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
+
+namespace {
+
+const char kKernelMagic[8] = {'E', 'M', 'O', 'K', 'E', 'R', 'N', '1'};
+constexpr uint32_t kKernelVersion = 1;
+
+// 与 --golden 的容差一致: Python参考实现为float64，C++为float32
+constexpr float kStandardizeTolerance = 1e-5f;
+constexpr float kFrontalTolerance = 1e-4f;
+constexpr float kFeatureTolerance = 1e-4f;
+
+struct KernelFixtures {
+    int num_cases = 0;
+    std::vector<float> weights;         // 137 x 136
+    std::vector<float> raw_landmarks;   // num_cases x 136，交错的 x, y
+    std::vector<float> standardized;    // num_cases x 137
+    std::vector<float> frontal;         // num_cases x 136
+    std::vector<float> reduced;         // num_cases x 1275
+    std::vector<float> full;            // num_cases x 2278
+};
+
+bool readFloats(std::ifstream& file, std::vector<float>& values, size_t count) {
+    values.resize(count);
+    file.read(reinterpret_cast<char*>(values.data()), static_cast<std::streamsize>(count * sizeof(float)));
+    return static_cast<bool>(file);
+}
+
+bool loadKernelFixtures(const std::string& path, KernelFixtures& fixtures) {
+    using namespace LandmarkKernels;
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file.is_open()) {
+        std::cerr << "无法打开内核回归数据: " << path << "（运行 generate_golden_fixtures.py --kernels 生成）"
+                  << std::endl;
+        return false;
+    }
+    const uint64_t file_size = static_cast<uint64_t>(file.tellg());
+    file.seekg(0);
+
+    char magic[8];
+    uint32_t header[3];  // version, num_cases, num_landmarks
+    file.read(magic, sizeof(magic));
+    file.read(reinterpret_cast<char*>(header), sizeof(header));
+    if (!file || std::memcmp(magic, kKernelMagic, sizeof(magic)) != 0 || header[0] != kKernelVersion ||
+        header[2] != static_cast<uint32_t>(kNumLandmarks)) {
+        std::cerr << "内核回归数据格式无效: " << path << std::endl;
+        return false;
+    }
+
+    const uint64_t weights = static_cast<uint64_t>(kFrontalInputDim) * kFrontalOutputDim;
+    const uint64_t per_case = 2 * kNumLandmarks + kFrontalInputDim + kFrontalOutputDim +
+                              featureCount(false) + featureCount(true);
+    const uint64_t expected = sizeof(magic) + sizeof(header) + (weights + header[1] * per_case) * sizeof(float);
+    if (header[1] == 0 || file_size != expected) {
+        std::cerr << "内核回归数据大小与文件头不符: " << path << std::endl;
+        return false;
+    }
+
+    fixtures.num_cases = static_cast<int>(header[1]);
+    const size_t n = fixtures.num_cases;
+    if (!readFloats(file, fixtures.weights, weights) ||
+        !readFloats(file, fixtures.raw_landmarks, n * 2 * kNumLandmarks) ||
+        !readFloats(file, fixtures.standardized, n * kFrontalInputDim) ||
+        !readFloats(file, fixtures.frontal, n * kFrontalOutputDim) ||
+        !readFloats(file, fixtures.reduced, n * featureCount(false)) ||
+        !readFloats(file, fixtures.full, n * featureCount(true))) {
+        std::cerr << "内核回归数据不完整: " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// 逐样本比较并打印一行结果，返回是否全部在容差内
+bool compareStage(const std::string& stage, float tolerance, const std::vector<float>& actual,
+                  const std::vector<float>& expected, int num_cases, int dim) {
+    float max_difference = 0.0f;
+    int failed_cases = 0;
+    for (int i = 0; i < num_cases; ++i) {
+        float case_max = 0.0f;
+        for (int j = 0; j < dim; ++j) {
+            const size_t idx = static_cast<size_t>(i) * dim + j;
+            const float diff = std::abs(actual[idx] - expected[idx]);
+            // NaN never compares greater, so count it as a failure explicitly
+            if (std::isnan(diff)) {
+                case_max = std::numeric_limits<float>::infinity();
+            } else {
+                case_max = std::max(case_max, diff);
+            }
+        }
+        failed_cases += case_max > tolerance ? 1 : 0;
+        max_difference = std::max(max_difference, case_max);
+    }
+
+    std::cout << std::left << std::setw(24) << stage << std::scientific << std::setprecision(1)
+              << std::setw(12) << tolerance << std::setprecision(3) << std::setw(14) << max_difference
+              << failed_cases << (failed_cases == 0 ? "  ✅" : "  ❌") << std::endl;
+    return failed_cases == 0;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    using namespace LandmarkKernels;
+    std::cout << "=== 数值内核黄金回归测试 ===" << std::endl;
+
+    const std::string path = argc > 1 ? argv[1] : "../data/golden/kernel_fixtures.bin";
+    KernelFixtures fixtures;
+    if (!loadKernelFixtures(path, fixtures)) {
+        return 1;
+    }
+
+    const int n = fixtures.num_cases;
+    const int raw_dim = 2 * kNumLandmarks;
+    std::cout << "样本数: " << n << ", OpenBLAS: " << (blasAvailable() ? "是" : "否") << std::endl;
+    std::cout << std::left << std::setw(24) << "阶段" << std::setw(12) << "容差" << std::setw(14) << "最大差异"
+              << "失败样本" << std::endl;
+
+    bool passed = true;
+
+    // 1. Procrustes标准化
+    std::vector<float> rows(static_cast<size_t>(n) * kFrontalInputDim);
+    for (int i = 0; i < n; ++i) {
+        standardizeToFeatureRow(&fixtures.raw_landmarks[static_cast<size_t>(i) * raw_dim],
+                                &rows[static_cast<size_t>(i) * kFrontalInputDim]);
+    }
+    passed &= compareStage("standardize", kStandardizeTolerance, rows, fixtures.standardized, n, kFrontalInputDim);
+
+    // 2. 正面化: 输入为Python的标准化行，只比较矩阵乘本身
+    const float* golden_rows = fixtures.standardized.data();
+    std::vector<float> frontal(static_cast<size_t>(n) * kFrontalOutputDim);
+    for (int i = 0; i < n; ++i) {
+        frontalizeRow(golden_rows + static_cast<size_t>(i) * kFrontalInputDim, fixtures.weights.data(),
+                      &frontal[static_cast<size_t>(i) * kFrontalOutputDim]);
+    }
+    passed &= compareStage("frontalize_row", kFrontalTolerance, frontal, fixtures.frontal, n, kFrontalOutputDim);
+
+    std::vector<float> batch(static_cast<size_t>(n) * kFrontalOutputDim);
+    gemm(n, kFrontalOutputDim, kFrontalInputDim, golden_rows, kFrontalInputDim,
+         fixtures.weights.data(), kFrontalOutputDim, batch.data(), kFrontalOutputDim);
+    passed &= compareStage("frontalize_gemm", kFrontalTolerance, batch, fixtures.frontal, n, kFrontalOutputDim);
+
+    const std::vector<float> packed = packWeightPanels(fixtures.weights.data(), kFrontalInputDim, kFrontalOutputDim);
+    std::fill(batch.begin(), batch.end(), 0.0f);
+    gemmPacked(n, kFrontalOutputDim, kFrontalInputDim, golden_rows, kFrontalInputDim,
+               packed.data(), batch.data(), kFrontalOutputDim);
+    passed &= compareStage("frontalize_packed", kFrontalTolerance, batch, fixtures.frontal, n, kFrontalOutputDim);
+
+    // 3. 几何特征: 分步（Python的正面化结果 -> 特征）与融合内核（原始关键点 -> 特征）
+    for (bool full : {false, true}) {
+        const int dim = featureCount(full);
+        const std::vector<float>& expected = full ? fixtures.full : fixtures.reduced;
+        std::vector<float> staged(static_cast<size_t>(n) * dim);
+        std::vector<float> fused(static_cast<size_t>(n) * dim);
+        bool sizes_match = true;
+        for (int i = 0; i < n; ++i) {
+            sizes_match &= pairwiseDistanceFeatures(&fixtures.frontal[static_cast<size_t>(i) * kFrontalOutputDim],
+                                                    full, &staged[static_cast<size_t>(i) * dim]) == dim;
+            sizes_match &= computeModelFeatures(&fixtures.raw_landmarks[static_cast<size_t>(i) * raw_dim],
+                                                fixtures.weights.data(), full,
+                                                &fused[static_cast<size_t>(i) * dim]) == dim;
+        }
+        if (!sizes_match) {
+            std::cerr << "特征维度与featureCount不一致" << std::endl;
+            return 1;
+        }
+        const std::string suffix = full ? "_full" : "_reduced";
+        passed &= compareStage("features" + suffix, kFeatureTolerance, staged, expected, n, dim);
+        passed &= compareStage("features_fused" + suffix, kFeatureTolerance, fused, expected, n, dim);
+    }
+
+    std::cout << (passed ? "✅ 通过" : "❌ 失败: 存在超出容差的阶段") << std::endl;
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,139 @@
+// 共享模型页测试: 比较从.dat解析（进程私有堆内存）与映射扁平文件（页缓存中的共享文件页）加载关键点模型时
+// 本进程的私有内存和文件页增量。映射加载的私有内存增量应接近0，同一主机上的N个工作进程因此只占一份物理内存
+#include "ert_shape_predictor.h"
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <psapi.h>
+#endif
+
+// 进程常驻内存（MB）: 私有（匿名）页与文件映射页
+struct ProcessMemory {
+    double private_mb = 0.0;
+    double file_mb = 0.0;
+    bool available = false;
+};
+
+static ProcessMemory currentMemory() {
+    ProcessMemory memory;
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS_EX counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), reinterpret_cast<PROCESS_MEMORY_COUNTERS*>(&counters),
+                             sizeof(counters))) {
+        // 提交的私有字节；工作集中其余部分主要是映射的文件页
+        memory.private_mb = counters.PrivateUsage / (1024.0 * 1024.0);
+        memory.file_mb = (counters.WorkingSetSize > counters.PrivateUsage
+            ? counters.WorkingSetSize - counters.PrivateUsage : 0) / (1024.0 * 1024.0);
+        memory.available = true;
+    }
+#else
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line)) {
+        std::istringstream fields(line);
+        std::string key;
+        double kb = 0.0;
+        fields >> key >> kb;
+        if (key == "RssAnon:") {
+            memory.private_mb = kb / 1024.0;
+            memory.available = true;
+        } else if (key == "RssFile:") {
+            memory.file_mb = kb / 1024.0;
+        }
+    }
+#endif
+    return memory;
+}
+
+// 在合成噪声帧的一组人脸框上回归关键点，返回全部坐标（用于一致性比较）
+static std::vector<cv::Point2f> runPredictions(const ErtShapePredictor& predictor, const cv::Mat& gray) {
+    std::vector<cv::Point2f> all;
+    std::vector<cv::Point2f> landmarks;
+    for (int size = 80; size <= 320; size += 40) {
+        for (int y = 0; y + size <= gray.rows; y += 37) {
+            for (int x = 0; x + size <= gray.cols; x += 53) {
+                predictor.predict(gray, cv::Rect(x, y, size, size), landmarks);
+                all.insert(all.end(), landmarks.begin(), landmarks.end());
+            }
+        }
+    }
+    return all;
+}
+
+static void printDelta(const char* label, const ProcessMemory& before, const ProcessMemory& after) {
+    std::cout << std::fixed << std::setprecision(1) << label << ": 私有 +"
+              << after.private_mb - before.private_mb << " MB, 文件页 +"
+              << after.file_mb - before.file_mb << " MB" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    std::cout << "=== 共享模型页测试 ===" << std::endl;
+
+    const std::string dat_path = argc > 1 ? argv[1] : "shape_predictor_68_face_landmarks.dat";
+    const std::string flat_path = argc > 2 ? argv[2] : "shape_predictor_68_face_landmarks.ertf";
+
+    if (!currentMemory().available) {
+        std::cout << "⚠️ 当前平台无法读取进程内存统计，跳过" << std::endl;
+        return 0;
+    }
+
+    cv::Mat gray(480, 640, CV_8UC1);
+    cv::randu(gray, 0, 255);
+
+    // 1. 从.dat解析: 模型位于进程私有堆内存
+    ErtShapePredictor parsed;
+    std::vector<cv::Point2f> parsed_landmarks;
+    ProcessMemory before = currentMemory();
+    if (parsed.load(dat_path)) {
+        parsed_landmarks = runPredictions(parsed, gray);
+        printDelta("解析.dat", before, currentMemory());
+        if (!ErtShapePredictor::isFlatFile(flat_path) && !parsed.saveFlat(flat_path)) {
+            return 1;
+        }
+    } else if (!ErtShapePredictor::isFlatFile(flat_path)) {
+        std::cout << "⚠️ 无法加载 " << dat_path << " 且没有扁平模型 " << flat_path << "，跳过" << std::endl;
+        return 0;
+    }
+
+    // 2. 映射扁平文件: 模型页为共享的文件页
+    ErtShapePredictor mapped;
+    before = currentMemory();
+    if (!mapped.load(flat_path) || !mapped.isMapped()) {
+        std::cerr << "无法映射扁平模型: " << flat_path << std::endl;
+        return 1;
+    }
+    std::vector<cv::Point2f> mapped_landmarks = runPredictions(mapped, gray);
+    const ProcessMemory after = currentMemory();
+    printDelta("映射扁平文件", before, after);
+
+    const double model_mb = mapped.modelBytes() / (1024.0 * 1024.0);
+    const double private_growth = after.private_mb - before.private_mb;
+    std::cout << "模型大小: " << std::setprecision(1) << model_mb << " MB" << std::endl;
+
+    // 私有增量只应来自结果缓冲区和校验用的小数组
+    bool passed = private_growth < 0.05 * model_mb + 4.0;
+    if (!passed) {
+        std::cout << "❌ 映射加载的私有内存增量过大" << std::endl;
+    }
+
+    if (!parsed_landmarks.empty()) {
+        bool same = parsed_landmarks.size() == mapped_landmarks.size();
+        for (size_t i = 0; same && i < parsed_landmarks.size(); ++i) {
+            same = parsed_landmarks[i].x == mapped_landmarks[i].x && parsed_landmarks[i].y == mapped_landmarks[i].y;
+        }
+        std::cout << "解析与映射的关键点" << (same ? "一致" : "不一致") << " (" << parsed_landmarks.size()
+                  << " 个点)" << std::endl;
+        passed = passed && same;
+    }
+
+    std::cout << (passed ? "✅ 通过" : "❌ 失败") << std::endl;
+    return passed ? 0 : 1;
+}
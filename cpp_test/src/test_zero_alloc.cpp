@@ -0,0 +1,240 @@
+// 零堆分配测试: 用计数的全局operator new（含对齐与nothrow重载）验证工作区版本的分析路径在预热后不再分配。
+// 强制检查两段: 从关键点开始的analyzeLandmarks，以及固定图像上跳过检测的analyzeEmotion（关键点回归+特征+推理）。
+// 含检测的analyzeEmotion(image, workspace, result)只报告分配次数: dlib的HOG金字塔和检测结果逐帧分配
+#include "emotion_analyzer.h"
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <random>
+
+static std::atomic<bool> g_counting{false};
+static std::atomic<long long> g_allocations{0};
+
+static void countAllocation() {
+    if (g_counting.load(std::memory_order_relaxed)) {
+        g_allocations.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+static void* allocate(std::size_t size) {
+    countAllocation();
+    return std::malloc(size ? size : 1);
+}
+
+static void* allocateAligned(std::size_t size, std::align_val_t alignment) {
+    countAllocation();
+    const std::size_t align = static_cast<std::size_t>(alignment);
+#ifdef _WIN32
+    return _aligned_malloc(size ? size : 1, align);
+#else
+    // aligned_alloc requires the size to be a multiple of the alignment
+    return std::aligned_alloc(align, ((size ? size : 1) + align - 1) / align * align);
+#endif
+}
+
+static void freeAligned(void* p) {
+#ifdef _WIN32
+    _aligned_free(p);
+#else
+    std::free(p);
+#endif
+}
+
+void* operator new(std::size_t size) {
+    if (void* p = allocate(size)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) {
+    return operator new(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    return allocate(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+    return allocate(size);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment) {
+    if (void* p = allocateAligned(size, alignment)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment) {
+    return operator new(size, alignment);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    return allocateAligned(size, alignment);
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    return allocateAligned(size, alignment);
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, const std::nothrow_t&) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p, const std::nothrow_t&) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::align_val_t) noexcept {
+    freeAligned(p);
+}
+
+void operator delete[](void* p, std::align_val_t) noexcept {
+    freeAligned(p);
+}
+
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept {
+    freeAligned(p);
+}
+
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept {
+    freeAligned(p);
+}
+
+void operator delete(void* p, std::align_val_t, const std::nothrow_t&) noexcept {
+    freeAligned(p);
+}
+
+void operator delete[](void* p, std::align_val_t, const std::nothrow_t&) noexcept {
+    freeAligned(p);
+}
+
+// 统计fn执行iterations次期间的堆分配次数
+template <typename Fn>
+static long long countAllocations(int iterations, Fn fn) {
+    g_allocations.store(0);
+    g_counting.store(true);
+    for (int i = 0; i < iterations; ++i) {
+        fn();
+    }
+    g_counting.store(false);
+    return g_allocations.load();
+}
+
+static std::vector<cv::Point2f> makeLandmarks(std::mt19937& gen) {
+    std::normal_distribution<float> dis(0.0f, 1.0f);
+    std::vector<cv::Point2f> landmarks;
+    for (int i = 0; i < 68; ++i) {
+        landmarks.emplace_back(320.0f + 60.0f * dis(gen), 240.0f + 60.0f * dis(gen));
+    }
+    return landmarks;
+}
+
+int main(int argc, char* argv[]) {
+    std::cout << "=== 零堆分配测试 ===" << std::endl;
+
+    EmotionAnalyzer analyzer("model_emotion_pls30.onnx",
+                             "model_frontalization.npy",
+                             "shape_predictor_68_face_landmarks.dat");
+    // 只加载关键点之后的模型；人脸框在计数前检测一次
+    if (!analyzer.initialize(EmotionAnalyzer::LANDMARKS | EmotionAnalyzer::FRONTALIZE | EmotionAnalyzer::INFER)) {
+        std::cerr << "初始化失败" << std::endl;
+        return 1;
+    }
+
+    AnalysisWorkspace workspace;
+    if (!analyzer.prepareWorkspace(workspace)) {
+        std::cerr << "工作区准备失败" << std::endl;
+        return 1;
+    }
+
+    std::mt19937 gen(7);
+    std::vector<std::vector<cv::Point2f>> inputs;
+    for (int i = 0; i < 16; ++i) {
+        inputs.push_back(makeLandmarks(gen));
+    }
+
+    EmotionResult result;
+    size_t next = 0;
+    auto analyzeNext = [&]() {
+        analyzer.analyzeLandmarks(inputs[next++ % inputs.size()], workspace, result);
+    };
+
+    // 预热: 首帧允许分配（结果字符串容量、ORT内部的惰性初始化）
+    for (int i = 0; i < 5; ++i) {
+        analyzeNext();
+    }
+
+    const int iterations = 1000;
+    long long allocations = countAllocations(iterations, analyzeNext);
+    std::cout << "analyzeLandmarks: " << iterations << " 帧, 堆分配 " << allocations << " 次" << std::endl;
+    bool passed = (allocations == 0);
+
+    // 检测之后的整段: 固定图像（CTest传入数据集图像，未给出时用合成帧）上的固定人脸框
+    cv::Mat image;
+    if (argc > 1) {
+        image = cv::imread(argv[1]);
+        if (image.empty()) {
+            std::cerr << "无法读取图像: " << argv[1] << std::endl;
+            return 1;
+        }
+    } else {
+        image.create(480, 640, CV_8UC3);
+        cv::randu(image, 0, 255);
+    }
+
+    cv::Rect face(image.cols / 4, image.rows / 4, image.cols / 2, image.rows / 2);
+    std::vector<DetectedFace> faces = analyzer.detectFaces(image);
+    if (!faces.empty()) {
+        face = faces[0].rect;
+    } else if (argc > 1) {
+        std::cout << "⚠️ 图像中未检测到人脸，使用中心区域" << std::endl;
+    }
+
+    if (!analyzer.analyzeEmotion(image, face, workspace, result)) {
+        std::cerr << "人脸框分析失败" << std::endl;
+        return 1;
+    }
+    const int image_iterations = 200;
+    long long image_allocations = countAllocations(image_iterations, [&]() {
+        analyzer.analyzeEmotion(image, face, workspace, result);
+    });
+    std::cout << "analyzeEmotion(image, rect): " << image_iterations << " 帧, 堆分配 " << image_allocations
+              << " 次" << std::endl;
+    passed = passed && image_allocations == 0;
+
+    // Detection is the documented exception; report its cost so a change there is visible
+    if (analyzer.initialize(EmotionAnalyzer::DETECT)) {
+        analyzer.analyzeEmotion(image, workspace, result);
+        const int detect_iterations = 50;
+        long long detect_allocations = countAllocations(detect_iterations, [&]() {
+            analyzer.analyzeEmotion(image, workspace, result);
+        });
+        std::cout << "analyzeEmotion(image)（含检测，不强制）: " << detect_iterations << " 帧, 堆分配 "
+                  << detect_allocations << " 次（每帧 " << detect_allocations / detect_iterations << " 次）"
+                  << std::endl;
+    } else {
+        std::cout << "⚠️ 人脸检测器加载失败，跳过含检测路径的统计" << std::endl;
+    }
+
+    std::cout << (passed ? "✅ 通过" : "❌ 失败: 稳态下存在堆分配") << std::endl;
+    return passed ? 0 : 1;
+}
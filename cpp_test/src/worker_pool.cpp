@@ -0,0 +1,81 @@
+#include "worker_pool.h"
+
+WorkerPool::~WorkerPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    start_.notify_all();
+    for (auto& thread : threads_) {
+        thread.join();
+    }
+}
+
+void WorkerPool::run(int count, const std::function<void(int)>& fn) {
+    if (count <= 1) {
+        fn(0);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        // Threads are only ever added; a smaller round leaves the extra ones asleep
+        while (static_cast<int>(threads_.size()) < count - 1) {
+            const int index = static_cast<int>(threads_.size()) + 1;
+            threads_.emplace_back(&WorkerPool::workerLoop, this, index, generation_);
+        }
+        job_ = &fn;
+        participants_ = count;
+        remaining_ = count - 1;
+        error_ = nullptr;
+        ++generation_;
+    }
+    start_.notify_all();
+
+    std::exception_ptr caller_error;
+    try {
+        fn(0);
+    } catch (...) {
+        caller_error = std::current_exception();
+    }
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_.wait(lock, [this]() { return remaining_ == 0; });
+    job_ = nullptr;
+    if (caller_error) {
+        std::rethrow_exception(caller_error);
+    }
+    if (error_) {
+        std::rethrow_exception(error_);
+    }
+}
+
+void WorkerPool::workerLoop(int index, uint64_t generation) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+        start_.wait(lock, [&]() { return stop_ || generation_ != generation; });
+        if (stop_) {
+            return;
+        }
+        generation = generation_;
+        if (index >= participants_) {
+            continue;
+        }
+
+        const std::function<void(int)>* job = job_;
+        lock.unlock();
+        std::exception_ptr error;
+        try {
+            (*job)(index);
+        } catch (...) {
+            error = std::current_exception();
+        }
+        lock.lock();
+        if (error && !error_) {
+            error_ = error;
+        }
+        if (--remaining_ == 0) {
+            done_.notify_one();
+        }
+    }
+}
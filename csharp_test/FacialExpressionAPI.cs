@@ -19,6 +19,64 @@ namespace FacialExpressionAnalysis
         public string ErrorMessage;
     }
 
+    // 紧凑结果: 只含数值和标签编码，可直接blit，无字符串封送
+    [StructLayout(LayoutKind.Sequential)]
+    public struct EmotionResultCompact
+    {
+        public float Arousal;
+        public float Valence;
+        public float Intensity;
+        public int LabelId;         // 0-23，-1 为Neutral，-2 为Unknown
+        public int IntensityLevel;  // 0-3，Neutral时为-1
+        public int Success;
+    }
+
+    // 人脸检测配置: 全零（PyramidRatio为0时取5/6）即dlib默认检测
+    [StructLayout(LayoutKind.Sequential)]
+    public struct DetectorConfig
+    {
+        public int MinFaceSize;      // 最小人脸边长（像素），0为默认
+        public int MaxFaceSize;      // 最大人脸边长（像素），0为不限
+        public double PyramidRatio;  // 金字塔相邻层缩放比例 (0, 1)
+        public double Threshold;     // 检测阈值偏移，越大越严格
+        public int Upsample;         // 上采样次数
+        public int Ladder;           // 非0时启用检测阶梯（最小人脸160/80/40，未检测到才继续下一级）
+
+        [MarshalAs(UnmanagedType.LPStr)]
+        public string Backend;       // "hog"、"haar"、"lbp" 或级联模型文件路径；null为默认
+        public int Threads;          // HOG检测线程数，0为硬件线程数
+        public int TileSize;         // 分块检测的块边长，0为不分块
+        public int TileOverlap;      // 相邻块的重叠像素，0时取默认值256
+    }
+
+    // 人脸框（图像坐标）
+    [StructLayout(LayoutKind.Sequential)]
+    public struct FaceRect
+    {
+        public int X;
+        public int Y;
+        public int Width;
+        public int Height;
+    }
+
+    // 相机YUV 4:2:0帧: 与C端 YUVFrameDLL 布局一致；只使用Y平面，色度平面可为IntPtr.Zero
+    [StructLayout(LayoutKind.Sequential)]
+    public struct YUVFrame
+    {
+        public const int FormatNV12 = 0;
+        public const int FormatI420 = 1;
+
+        public IntPtr Plane0;   // Y
+        public IntPtr Plane1;   // NV12: UV；I420: U
+        public IntPtr Plane2;   // I420: V
+        public int Stride0;
+        public int Stride1;
+        public int Stride2;
+        public int Width;
+        public int Height;
+        public int Format;
+    }
+
     public static class FacialExpressionAPI
     {
         private const string DLL_NAME = "FacialExpressionDLL.dll";
@@ -44,6 +102,102 @@ namespace FacialExpressionAnalysis
             int channels
         );
 
+        [DllImport(DLL_NAME, CallingConvention = CallingConvention.Cdecl)]
+        public static extern EmotionResultCompact AnalyzeEmotionFromFileCompact(
+            [MarshalAs(UnmanagedType.LPStr)] string imagePath
+        );
+
+        [DllImport(DLL_NAME, CallingConvention = CallingConvention.Cdecl)]
+        public static extern EmotionResultCompact AnalyzeEmotionFromBytesCompact(
+            byte[] imageData,
+            int dataLength,
+            int width,
+            int height,
+            int channels
+        );
+
+        // 在已知人脸框上分析（跳过人脸检测）；results长度须不小于numRects，返回成功分析的人脸数，失败返回-1
+        [DllImport(DLL_NAME, CallingConvention = CallingConvention.Cdecl)]
+        public static extern int AnalyzeEmotionInRects(
+            byte[] imageData,
+            int dataLength,
+            int width,
+            int height,
+            int channels,
+            [In] FaceRect[] rects,
+            int numRects,
+            [Out] EmotionResultCompact[] results
+        );
+
+        // YUV帧输入: 直接在Y平面上分析，无颜色转换和拷贝
+        [DllImport(DLL_NAME, CallingConvention = CallingConvention.Cdecl)]
+        public static extern EmotionResult AnalyzeEmotionFromYUVFrame(ref YUVFrame frame);
+
+        [DllImport(DLL_NAME, CallingConvention = CallingConvention.Cdecl)]
+        public static extern EmotionResultCompact AnalyzeEmotionFromYUVFrameCompact(ref YUVFrame frame);
+
+        // 设置人脸检测配置，初始化前后均可调用；参数无效返回0
+        [DllImport(DLL_NAME, CallingConvention = CallingConvention.Cdecl)]
+        public static extern int SetDetectorConfig(ref DetectorConfig config);
+
+        // 关键点快速模式: 只运行前cascades级级联、每级前trees棵树，0表示全部；参数为负返回0
+        [DllImport(DLL_NAME, CallingConvention = CallingConvention.Cdecl)]
+        public static extern int SetLandmarkBudget(int cascades, int trees);
+
+        // 视频关键点跟踪: 非0时紧凑接口和YUV帧接口从上一帧关键点热启动（同一路视频流的连续帧）
+        [DllImport(DLL_NAME, CallingConvention = CallingConvention.Cdecl)]
+        public static extern void SetLandmarkTracking(int enabled);
+
+        // ONNX图优化级别（0-3，默认2）与优化模型缓存目录；cacheDir为null使用默认目录，""表示不缓存
+        [DllImport(DLL_NAME, CallingConvention = CallingConvention.Cdecl)]
+        public static extern int SetOnnxSessionOptions(int optimizationLevel,
+            [MarshalAs(UnmanagedType.LPStr)] string cacheDir);
+
+        // 大图降分辨率解码的目标长边（默认1280），0表示始终全分辨率
+        [DllImport(DLL_NAME, CallingConvention = CallingConvention.Cdecl)]
+        public static extern void SetDecodeMaxSide(int maxSide);
+
+        // 返回达到稳态的轮次（>0），未达到稳态返回0，失败返回-1
+        [DllImport(DLL_NAME, CallingConvention = CallingConvention.Cdecl)]
+        public static extern int WarmupEmotionAnalyzer(int iterations, int width, int height);
+
+        // 热重载模型，null表示保留当前模型；可与分析并发调用，失败时保留原模型并返回0
+        [DllImport(DLL_NAME, CallingConvention = CallingConvention.Cdecl)]
+        public static extern int ReloadEmotionModels(
+            [MarshalAs(UnmanagedType.LPStr)] string onnxModelPath,
+            [MarshalAs(UnmanagedType.LPStr)] string shapePredictorPath,
+            [MarshalAs(UnmanagedType.LPStr)] string frontalizationModelPath
+        );
+
+        // 返回DLL内的静态字符串，不能由封送器释放，因此按IntPtr接收
+        [DllImport(DLL_NAME, CallingConvention = CallingConvention.Cdecl, EntryPoint = "GetEmotionLabel")]
+        private static extern IntPtr GetEmotionLabelNative(int labelId, int intensityLevel);
+
+        // 24个扇区 x 4个强度等级，外加Neutral/Unknown
+        private static readonly string[] labelCache = new string[24 * 4 + 2];
+
+        // 标签编码对应的完整标签，每个编码只跨越P/Invoke边界一次
+        public static string GetEmotionLabel(int labelId, int intensityLevel)
+        {
+            int index;
+            if (labelId == -1) index = 24 * 4;
+            else if (labelId >= 0 && labelId < 24 && intensityLevel >= 0 && intensityLevel < 4) index = labelId * 4 + intensityLevel;
+            else index = 24 * 4 + 1;
+
+            string label = labelCache[index];
+            if (label == null)
+            {
+                label = Marshal.PtrToStringAnsi(GetEmotionLabelNative(labelId, intensityLevel));
+                labelCache[index] = label;
+            }
+            return label;
+        }
+
+        public static string GetEmotionLabel(EmotionResultCompact result)
+        {
+            return GetEmotionLabel(result.LabelId, result.IntensityLevel);
+        }
+
         [DllImport(DLL_NAME, CallingConvention = CallingConvention.Cdecl)]
         public static extern void ReleaseEmotionAnalyzer();
 